@@ -0,0 +1,341 @@
+/*
+ * stc3115d - owns the STC3115 gauges of a Linux host and publishes their measurements through shared memory.
+ *
+ * One thread per I2C bus runs every gauge of that bus on the cadence of its conversion counter and publishes
+ * each new measurement set to a POSIX shared memory region (layout in src/STC3115SharedRegion.h). Consumers map
+ * the region read-only with STC3115SharedRegion::open() and copy samples through a per-gauge sequence lock,
+ * without system calls and without touching the bus.
+ *
+ * Build from the repository root:
+ *     g++ -std=gnu++11 -O2 -Isrc extras/linux/stc3115d.cpp src/STC3115*.cpp -lpthread -lrt -o stc3115d
+ *
+ * Usage:
+ *     stc3115d [options] BUS:ADDRESS...   e.g. stc3115d /dev/i2c-1:0x70 /dev/i2c-2:0x70
+ *     stc3115d --simulate [options] [ADDRESS...]   simulated gauges on an in-process bus, 0x70 by default
+ *     stc3115d --read [--name NAME]   print the latest sample of every gauge and exit
+ *
+ * Options:
+ *     --name NAME        shared memory object, default /stc3115
+ *     --capacity MAH     nominal battery capacity passed to begin(), default 610
+ *     --rsense MOHM      sense resistor passed to begin(), default 50
+ *     --follow-phase     poll at the interval recommended for the charge phase instead of every conversion
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "STC3115.h"
+#include "STC3115LinuxI2C.h"
+#include "STC3115SharedRegion.h"
+#include "STC3115SimulatedI2CBus.h"
+
+#define STC3115D_RETRY_MS 50
+#define STC3115D_IDLE_MS 1000
+
+static volatile sig_atomic_t running = 1;
+
+struct Gauge {
+    STC3115* gauge;
+    int slot;
+    bool seen;
+    int lastCounter;
+    uint64_t nextPoll;
+};
+
+struct Worker {
+    std::string path;
+    STC3115I2CBus* bus;
+    std::vector<Gauge> gauges;
+    bool followPhase;
+    std::thread thread;
+};
+
+static void onSignal(int signal) {
+    (void) signal;
+    running = 0;
+}
+
+static uint64_t monotonicMs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+static void sleepMs(uint64_t ms) {
+    struct timespec delay;
+    delay.tv_sec = ms / 1000;
+    delay.tv_nsec = (ms % 1000) * 1000000;
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR && running) {
+    }
+}
+
+/**
+ * @brief Poll every gauge of a bus. A gauge is polled again one conversion period after a new conversion was seen,
+ * then every STC3115D_RETRY_MS until the next one shows up, so the daemon follows the gauge cadence with about two
+ * run() calls per conversion. With --follow-phase the longer interval recommended for the charge phase is used
+ * instead, trading freshness of the published samples for fewer bus transactions.
+ */
+static void poll(Worker* worker, STC3115SharedRegion* region) {
+    while (running) {
+        uint64_t now = monotonicMs();
+        uint64_t wake = now + STC3115D_IDLE_MS;
+
+        for (size_t i = 0; i < worker->gauges.size(); i++) {
+            Gauge& entry = worker->gauges[i];
+            if (now >= entry.nextPoll) {
+                STC3115BatteryData data;
+                entry.gauge->run();
+                if (entry.gauge->getSnapshot(&data) && (!entry.seen || data.ConvCounter != entry.lastCounter)) {
+                    region->publish(entry.slot, data, now);
+                    entry.seen = true;
+                    entry.lastCounter = data.ConvCounter;
+
+                    uint64_t period = (data.StatusWord & STC3115_VMODE) != 0 ? STC3115_CONV_PERIOD_VM_MS : STC3115_CONV_PERIOD_MIXED_MS;
+                    if (worker->followPhase && entry.gauge->getRecommendedPollInterval() > period) {
+                        period = entry.gauge->getRecommendedPollInterval();
+                    }
+                    entry.nextPoll = now + period - STC3115D_RETRY_MS;
+                } else {
+                    entry.nextPoll = now + STC3115D_RETRY_MS;
+                }
+            }
+
+            if (entry.nextPoll < wake) {
+                wake = entry.nextPoll;
+            }
+        }
+
+        now = monotonicMs();
+        if (wake > now) {
+            sleepMs(wake - now);
+        }
+    }
+}
+
+/**
+ * @brief Advance the simulated gauges by one conversion per period, with a slowly changing load.
+ */
+static void simulate(STC3115SimulatedI2CBus* bus, const std::vector<uint8_t>* addresses) {
+    int tick = 0;
+    while (running) {
+        for (size_t i = 0; i < addresses->size(); i++) {
+            int current = -150 - ((tick / 20 + static_cast<int>(i) * 7) % 10) * 40;
+            bus->setBattery((*addresses)[i], 3900 + current / 5, current, 25);
+        }
+
+        bus->step();
+        tick++;
+        sleepMs(STC3115_CONV_PERIOD_MIXED_MS);
+    }
+}
+
+static int dump(const char* name) {
+    STC3115SharedRegion region;
+    if (!region.open(name)) {
+        fprintf(stderr, "stc3115d: %s is not available\n", name);
+        return 1;
+    }
+
+    uint64_t now = monotonicMs();
+    for (int i = 0; i < region.getGaugeCount(); i++) {
+        const char* bus;
+        uint8_t address;
+        STC3115SharedSample sample;
+        stc3115_seq_t version;
+
+        region.getGauge(i, &bus, &address);
+        if (!region.read(i, &sample, &version)) {
+            printf("%s:0x%02x busy\n", bus, address);
+            continue;
+        }
+
+        printf("%s:0x%02x version %u age %llums soc %d.%d%% voltage %dmV current %dmA temperature %d.%dC charge %dmAh remaining %dmin%s\n",
+            bus, address, static_cast<unsigned>(version), static_cast<unsigned long long>(now - sample.Timestamp),
+            sample.SOC / 10, sample.SOC % 10, sample.Voltage, sample.Current, sample.Temperature / 10,
+            abs(sample.Temperature % 10), sample.ChargeValue, sample.RemTime,
+            (sample.Flags & STC3115_SHARED_FLAG_PROVISIONAL) != 0 ? " provisional" : "");
+    }
+
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: stc3115d [--name NAME] [--capacity MAH] [--rsense MOHM] [--follow-phase] BUS:ADDRESS...\n"
+                    "       stc3115d --simulate [--name NAME] [ADDRESS...]\n"
+                    "       stc3115d --read [--name NAME]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* name = STC3115_SHARED_NAME;
+    bool simulated = false;
+    bool read = false;
+    bool followPhase = false;
+    int capacity = BATT_CAPACITY;
+    int rSense = RSENSE;
+    std::vector<std::string> targets;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--simulate") == 0) {
+            simulated = true;
+        } else if (strcmp(argv[i], "--read") == 0) {
+            read = true;
+        } else if (strcmp(argv[i], "--name") == 0 && i + 1 < argc) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            capacity = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rsense") == 0 && i + 1 < argc) {
+            rSense = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--follow-phase") == 0) {
+            followPhase = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            targets.push_back(argv[i]);
+        }
+    }
+
+    if (read) {
+        return dump(name);
+    }
+
+    if (simulated && targets.empty()) {
+        targets.push_back("0x70");
+    }
+
+    if (targets.empty()) {
+        usage();
+        return 2;
+    }
+
+    STC3115SimulatedI2CBus simulatedBus;
+    std::vector<uint8_t> simulatedAddresses;
+    std::vector<Worker*> workers;
+    std::vector<STC3115*> gauges;
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        std::string path = simulated ? "simulated" : targets[i];
+        std::string address = targets[i];
+
+        if (!simulated) {
+            size_t colon = targets[i].rfind(':');
+            if (colon == std::string::npos) {
+                usage();
+                return 2;
+            }
+
+            path = targets[i].substr(0, colon);
+            address = targets[i].substr(colon + 1);
+        }
+
+        Worker* worker = NULL;
+        for (size_t j = 0; j < workers.size(); j++) {
+            if (workers[j]->path == path) {
+                worker = workers[j];
+            }
+        }
+
+        if (worker == NULL) {
+            worker = new Worker();
+            worker->path = path;
+            worker->followPhase = followPhase;
+            if (simulated) {
+                worker->bus = &simulatedBus;
+            } else {
+                STC3115LinuxI2CBus* bus = new STC3115LinuxI2CBus(worker->path.c_str());
+                if (!bus->open()) {
+                    fprintf(stderr, "stc3115d: cannot open %s: %s\n", worker->path.c_str(), strerror(errno));
+                    return 1;
+                }
+
+                worker->bus = bus;
+            }
+
+            workers.push_back(worker);
+        }
+
+        uint8_t value = static_cast<uint8_t>(strtol(address.c_str(), NULL, 0));
+        if (simulated) {
+            simulatedBus.addDevice(value, capacity, rSense);
+            simulatedAddresses.push_back(value);
+        }
+
+        Gauge entry;
+        entry.gauge = new STC3115(value);
+        entry.slot = -1;
+        entry.seen = false;
+        entry.lastCounter = 0;
+        entry.nextPoll = 0;
+        entry.gauge->attachBus(worker->bus);
+        entry.gauge->enableRegisterCache();
+#if STC3115_ENABLE_FAST_FIRST_READING
+        entry.gauge->enableFastFirstReading();
+#endif
+        if (!entry.gauge->begin(capacity, rSense)) {
+            fprintf(stderr, "stc3115d: gauge %s:0x%02x did not start, retrying from the polling loop\n", path.c_str(), value);
+        }
+
+        worker->gauges.push_back(entry);
+        gauges.push_back(entry.gauge);
+    }
+
+    STC3115SharedRegion region;
+    if (!region.create(name)) {
+        fprintf(stderr, "stc3115d: cannot create %s: %s\n", name, strerror(errno));
+        return 1;
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        for (size_t j = 0; j < workers[i]->gauges.size(); j++) {
+            Gauge& entry = workers[i]->gauges[j];
+            entry.slot = region.addGauge(workers[i]->path.c_str(), entry.gauge->getAddress());
+            if (entry.slot < 0) {
+                fprintf(stderr, "stc3115d: more than %d gauges\n", STC3115_SHARED_MAX_GAUGES);
+                return 1;
+            }
+        }
+    }
+
+    region.markReady();
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    std::thread simulator;
+    if (simulated) {
+        simulator = std::thread(simulate, &simulatedBus, &simulatedAddresses);
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->thread = std::thread(poll, workers[i], &region);
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i]->thread.join();
+        if (!simulated) {
+            delete workers[i]->bus;
+        }
+
+        delete workers[i];
+    }
+
+    if (simulator.joinable()) {
+        simulator.join();
+    }
+
+    for (size_t i = 0; i < gauges.size(); i++) {
+        delete gauges[i];
+    }
+
+    region.close();
+    return 0;
+}
@@ -1,8 +1,16 @@
 #include "STC3115.h"
-#include <Arduino.h>
 
+#if STC3115_ENABLE_DEBUG
 #define STC3115_DEBUG_PRINT(...) if (debugEnabled && debugStream != NULL) {  debugStream->print(__VA_ARGS__); }
 #define STC3115_DEBUG_PRINTLN(...) if (debugEnabled && debugStream != NULL) { debugStream->println(__VA_ARGS__); }
+#else
+#define STC3115_DEBUG_PRINT(...)
+#define STC3115_DEBUG_PRINTLN(...)
+#endif
+
+#if STC3115_OCV_OFFSET_IN_FLASH
+static const uint8_t STC3115_OCV_OFFSET[STC3115_OCVTAB_SIZE] STC3115_PROGMEM = {0};
+#endif
 
 /**
  * @brief Initialize STC3115 I2C driver with given address
@@ -11,8 +19,26 @@
  */
 STC3115::STC3115(uint8_t address):
  STC3115I2CCore(address),
- debugEnabled(0),
- debugStream(0) {}
+ cycleStep(STC3115_STEP_STATUS),
+ programStep(0),
+ resumeRegister(0),
+ resumeValue(0),
+ worstCaseTime(0),
+ worstTransactionTime(0)
+#if !STC3115_ENABLE_SNAPSHOT
+ , snapshotVersion(0)
+#endif
+#if STC3115_ENABLE_FAST_FIRST_READING
+ , fastFirstReading(false)
+ , firstSamplePending(false)
+ , initTime(0)
+ , firstSampleTime(0)
+#endif
+#if STC3115_ENABLE_DEBUG
+ , debugEnabled(0)
+ , debugStream(0)
+#endif
+ {}
 
 STC3115::~STC3115() {}
 
@@ -26,10 +52,15 @@ STC3115::~STC3115() {}
  */
 bool STC3115::begin(int battCapacity, int rSense) {
     beginI2C();
+    invalidateRegisterCache();
+    cycleStep = STC3115_STEP_STATUS;
 
     bool retval = true;
 
     initConfig(battCapacity, rSense);
+#if STC3115_ENABLE_HEALTH
+    health.setNominalCapacity(battCapacity);
+#endif
     readRAMData();
     if (ramData.reg.TestWord != RAM_TESTWORD || calculateCRC8RAM(ramData.db, STC3115_RAM_SIZE) != 0) {
         STC3115_DEBUG_PRINTLN("Invalid RAM data");
@@ -37,11 +68,14 @@ bool STC3115::begin(int battCapacity, int rSense) {
         initRAM();
         retval = startup();
     } else {
+        loadTunedConfig();
+
         uint8_t data;
         readRegister(&data, STC3115_REG_CTRL);
 
         if ((data & (STC3115_BATFAIL | STC3115_PORDET)) != 0) {
             STC3115_DEBUG_PRINTLN("Fresh start up");
+            invalidateRegisterCache();
             retval = startup();
         } else {
             STC3115_DEBUG_PRINTLN("Restore from RAM");
@@ -52,6 +86,7 @@ bool STC3115::begin(int battCapacity, int rSense) {
     ramData.reg.State = STC3115_INIT;
     updateRAMCRC8();
     writeRAMData();
+    startInit();
 
     return retval;
 }
@@ -66,6 +101,7 @@ int STC3115::getChipID() {
     bool readResult = readRegister(&res, STC3115_REG_ID);
     STC3115_DEBUG_PRINT("[DBG] CHIP ID READ RESULT: ");
     STC3115_DEBUG_PRINTLN(readResult);
+    (void)readResult;
 
     return static_cast<int>(res);
 }
@@ -119,7 +155,7 @@ int STC3115::updateRAMCRC8() {
 int STC3115::calculateCRC8RAM(uint8_t* data, size_t length) {
     int crc = 0;
 
-    for (int i = 0; i < length; i++) {
+    for (size_t i = 0; i < length; i++) {
         crc ^= data[i];
 
         for (int j = 0; j < 8; j++) {
@@ -155,17 +191,19 @@ void STC3115::initConfig(int battCapacity, int rSense) {
         config.RSense = 10;
     }
 
-    config.CCConf = (battCapacity * config.RSense * 250 + 6194) / 12389;
+    config.CCConf = (static_cast<long>(battCapacity) * config.RSense * 250 + 6194) / 12389;
 
     if (BATT_RINT != 0) {
-        config.VMConf = (battCapacity * BATT_RINT * 50 + 24444) / 48889;
+        config.VMConf = (static_cast<long>(battCapacity) * BATT_RINT * 50 + 24444) / 48889;
     } else {
-        config.VMConf = (battCapacity * 200 * 50 + 24444) / 48889;
+        config.VMConf = (static_cast<long>(battCapacity) * 200 * 50 + 24444) / 48889;
     }
 
+#if !STC3115_OCV_OFFSET_IN_FLASH
     for (int i = 0; i < 16; i++) {
        config.OCVOffset[i] = 0;
     }
+#endif
 
     config.CNom = battCapacity;
     config.RelaxCurrent = battCapacity / 20;
@@ -173,6 +211,7 @@ void STC3115::initConfig(int battCapacity, int rSense) {
     config.AlmVbat = ALM_VBAT;
 
     batteryData.Presence = 1;
+    batteryData.Provisional = 0;
 }
 
 /**
@@ -192,7 +231,11 @@ int STC3115::getStatus() {
         return -1;
     }
 
-    readRegisterRegion(data, STC3115_REG_MODE, 2);
+    // the chip ID may come from the register cache, so presence is only proven by reading the control register
+    if (!readRegisterRegion(data, STC3115_REG_MODE, 2)) {
+        return -1;
+    }
+
     value = data[0] | (data[1] << 8);
     value &= 0x7fff;
 
@@ -204,38 +247,64 @@ int STC3115::getStatus() {
  *
  */
 void STC3115::setParamAndRun() {
-    writeRegister(STC3115_REG_MODE, STC3115_REGMODE_DEFAULT_STANDBY);
-
-    writeRegister(STC3115_REG_OCVTAB0, config.OCVOffset, STC3115_OCVTAB_SIZE);
-
-    if (config.AlmSOC != 0) {
-        writeRegister(STC3115_REG_ALARM_SOC, config.AlmSOC * 2);
+    for (uint8_t step = 0; step < STC3115_PROGRAM_STEPS; step++) {
+        programParameter(step);
     }
+}
 
-    if (config.AlmVbat != 0) {
-        int value = static_cast<long>(config.AlmVbat << 9) / VoltageFactor;
-        writeRegister(STC3115_REG_ALARM_VOLTAGE, static_cast<uint8_t>(value));
+/**
+ * @brief Write one configuration register. setParamAndRun() runs every step in order; run() spreads them over calls.
+ *
+ * The gauge stays in standby from the first step until the last one starts it again.
+ *
+ * @param step step number, 0 to STC3115_PROGRAM_STEPS - 1
+ * @return true
+ * @return false
+ */
+bool STC3115::programParameter(uint8_t step) {
+    switch (step) {
+    case 0:
+        return writeRegister(STC3115_REG_MODE, STC3115_REGMODE_DEFAULT_STANDBY);
+    case 1: {
+#if STC3115_OCV_OFFSET_IN_FLASH
+        uint8_t ocvOffset[STC3115_OCVTAB_SIZE];
+        stc3115_read_flash(ocvOffset, STC3115_OCV_OFFSET, STC3115_OCVTAB_SIZE);
+        return writeRegister(STC3115_REG_OCVTAB0, ocvOffset, STC3115_OCVTAB_SIZE);
+#else
+        return writeRegister(STC3115_REG_OCVTAB0, config.OCVOffset, STC3115_OCVTAB_SIZE);
+#endif
     }
+    case 2:
+        if (config.AlmSOC != 0) {
+            return writeRegister(STC3115_REG_ALARM_SOC, config.AlmSOC * 2);
+        }
 
-    if (config.RSense != 0) {
-        int value = static_cast<long>(config.RelaxCurrent << 9) / (CurrentFactor / config.RSense);
-        writeRegister(STC3115_REG_CURRENT_THRES, static_cast<uint8_t>(value));
-    }
+        return true;
+    case 3:
+        if (config.AlmVbat != 0) {
+            int value = (static_cast<long>(config.AlmVbat) << 9) / VoltageFactor;
+            return writeRegister(STC3115_REG_ALARM_VOLTAGE, static_cast<uint8_t>(value));
+        }
 
-    if (config.CCConf != 0) {
-        writeRegisterInt(STC3115_REG_CC_CNF_L, config.CCConf);
-    } else {
-        writeRegisterInt(STC3115_REG_CC_CNF_L, 395);
-    }
+        return true;
+    case 4:
+        if (config.RSense != 0) {
+            int value = (static_cast<long>(config.RelaxCurrent) << 9) / (CurrentFactor / config.RSense);
+            return writeRegister(STC3115_REG_CURRENT_THRES, static_cast<uint8_t>(value));
+        }
 
-    if (config.VMConf != 0) {
-        writeRegisterInt(STC3115_REG_VM_CNF_L, config.VMConf);
-    } else {
-        writeRegisterInt(STC3115_REG_VM_CNF_L, 321);
+        return true;
+    case 5:
+        return writeRegisterInt(STC3115_REG_CC_CNF_L, config.CCConf != 0 ? config.CCConf : 395);
+    case 6:
+        return writeRegisterInt(STC3115_REG_VM_CNF_L, config.VMConf != 0 ? config.VMConf : 321);
+    case 7:
+        return writeRegister(STC3115_REG_CTRL, 0x03);
+    case 8:
+        return writeRegister(STC3115_REG_MODE, STC3115_GG_RUN | (STC3115_VMODE * config.VMode) | (STC3115_ALM_ENA * ALM_EN));
+    default:
+        return false;
     }
-
-    writeRegister(STC3115_REG_CTRL, 0x03);
-    writeRegister(STC3115_REG_MODE, STC3115_GG_RUN | (STC3115_VMODE * config.VMode) | (STC3115_ALM_ENA * ALM_EN));
 }
 
 /**
@@ -270,6 +339,18 @@ bool STC3115::startup() {
     return true;
 }
 
+/**
+ * @brief Take the VM_CNF value tuned at run time from a valid RAM image, so it is programmed instead of the default
+ * derived from BATT_RINT. The image is ignored when it was written for another CC_CNF, i.e. another battery or
+ * sense resistor.
+ *
+ */
+void STC3115::loadTunedConfig() {
+    if (ramData.reg.CCConf == config.CCConf && ramData.reg.VMConf > 0) {
+        config.VMConf = ramData.reg.VMConf;
+    }
+}
+
 /**
  * @brief Restore SOC value from RAM and run
  *
@@ -370,80 +451,99 @@ int STC3115::getRemainingTime() {
 }
 
 /**
- * @brief Read battery measurement data in one go.
+ * @brief Read battery measurement data.
+ *
+ * Only the registers of the requested fields are fetched, in as few transactions as computeReadSpans() allows,
+ * and only those fields are decoded. The other fields of the measurement set keep their previous value.
  *
+ * @param fields combination of STC3115_FIELD_* flags
  * @return true
  * @return false
  */
-bool STC3115::readBatteryData() {
-    uint8_t data[16];
+bool STC3115::readBatteryData(uint8_t fields) {
+    uint8_t data[STC3115_FIELD_BUFFER_SIZE];
+    STC3115ReadSpan spans[STC3115_FIELD_COUNT];
     bool retVal = true;
-    int value;
-
-    retVal = readRegisterRegion(data, 0, 16);
-    if (!retVal) {
-        STC3115_DEBUG_PRINT("[FAIL]: Return value: ");
-        STC3115_DEBUG_PRINTLN(retVal);
-        return retVal;
-    }
-
-    value = data[3];
-    value = (value << 8) + data[2];
-    batteryData.HRSOC = value;
-    batteryData.SOC = (value * 10 + 256) / 512;
-    STC3115_DEBUG_PRINT("[DBG] SOC: ");
-    STC3115_DEBUG_PRINTLN(batteryData.SOC);
-
-    value = data[5];
-    value = (value << 8) + data[4];
-    batteryData.ConvCounter = value;
-    STC3115_DEBUG_PRINT("[DBG] ConvCounter: ");
-    STC3115_DEBUG_PRINTLN(batteryData.ConvCounter);
-
-    value = data[7];
-    value = (value << 8) + data[6];
-    value = value & 0x3fff;
-    if (value >= 0x2000) {
-        value = value - 0x4000;
-    }
-
-    batteryData.Current = convert(value, CurrentFactor / config.RSense);
-    STC3115_DEBUG_PRINT("[DBG] Current: ");
-    STC3115_DEBUG_PRINTLN(batteryData.Current);
-
-    value = data[9];
-    value = (value << 8) + data[8];
-    value = value & 0x0fff;
-    if (value >= 0x0800) {
-        value = value - 0x1000;
-    }
-    batteryData.Voltage = convert(value, VoltageFactor);
-    STC3115_DEBUG_PRINT("[DBG] Voltage: ");
-    STC3115_DEBUG_PRINTLN(batteryData.Voltage);
-
-    value = data[10];
-    if (value >= 0x80) {
-        value = value - 0x100;
-    }
-    batteryData.Temperature = value * 10;
-    STC3115_DEBUG_PRINT("[DBG] Temperature: ");
-    STC3115_DEBUG_PRINTLN(batteryData.Temperature);
-
-    value = data[14];
-    value = (value << 8) | data[13];
-    value = value & 0x3fff;
-    if (value >= 0x02000) {
-        value = value - 0x4000;
-    }
-    value = convert(value, VoltageFactor);
-    value = (value + 2) / 4;
-    batteryData.OCV = value;
-    STC3115_DEBUG_PRINT("[DBG] OCV: ");
-    STC3115_DEBUG_PRINTLN(batteryData.OCV);
+
+    uint8_t spanCount = computeReadSpans(fields, spans);
+    for (uint8_t i = 0; i < spanCount; i++) {
+        retVal = readRegisterRegion(&data[spans[i].Start], spans[i].Start, spans[i].Length);
+        if (!retVal) {
+            STC3115_DEBUG_PRINT("[FAIL]: Return value: ");
+            STC3115_DEBUG_PRINTLN(retVal);
+            return retVal;
+        }
+    }
+
+    if ((fields & STC3115_FIELD_SOC) != 0) {
+        batteryData.HRSOC = stc3115ReadField<STC3115_FIELD_INDEX_SOC>(data);
+        batteryData.SOC = stc3115DecodeField<STC3115_FIELD_INDEX_SOC>(data, config.RSense);
+        STC3115_DEBUG_PRINT("[DBG] SOC: ");
+        STC3115_DEBUG_PRINTLN(batteryData.SOC);
+    }
+
+    if ((fields & STC3115_FIELD_COUNTER) != 0) {
+        batteryData.ConvCounter = stc3115DecodeField<STC3115_FIELD_INDEX_COUNTER>(data, config.RSense);
+        STC3115_DEBUG_PRINT("[DBG] ConvCounter: ");
+        STC3115_DEBUG_PRINTLN(batteryData.ConvCounter);
+    }
+
+    if ((fields & STC3115_FIELD_CURRENT) != 0) {
+        batteryData.Current = stc3115DecodeField<STC3115_FIELD_INDEX_CURRENT>(data, config.RSense);
+        STC3115_DEBUG_PRINT("[DBG] Current: ");
+        STC3115_DEBUG_PRINTLN(batteryData.Current);
+    }
+
+    if ((fields & STC3115_FIELD_VOLTAGE) != 0) {
+        batteryData.Voltage = stc3115DecodeField<STC3115_FIELD_INDEX_VOLTAGE>(data, config.RSense);
+        STC3115_DEBUG_PRINT("[DBG] Voltage: ");
+        STC3115_DEBUG_PRINTLN(batteryData.Voltage);
+    }
+
+    if ((fields & STC3115_FIELD_TEMPERATURE) != 0) {
+        batteryData.Temperature = stc3115DecodeField<STC3115_FIELD_INDEX_TEMPERATURE>(data, config.RSense);
+        STC3115_DEBUG_PRINT("[DBG] Temperature: ");
+        STC3115_DEBUG_PRINTLN(batteryData.Temperature);
+    }
+
+    if ((fields & STC3115_FIELD_OCV) != 0) {
+        batteryData.OCV = stc3115DecodeField<STC3115_FIELD_INDEX_OCV>(data, config.RSense);
+        STC3115_DEBUG_PRINT("[DBG] OCV: ");
+        STC3115_DEBUG_PRINTLN(batteryData.OCV);
+    }
+
+#if STC3115_ENABLE_STATISTICS
+    uint8_t statisticsFields = STC3115_FIELD_COUNTER | STC3115_FIELD_CURRENT | STC3115_FIELD_VOLTAGE | STC3115_FIELD_TEMPERATURE;
+    if ((fields & statisticsFields) == statisticsFields) {
+        statistics.update(batteryData);
+    }
+#endif
 
     return true;
 }
 
+/**
+ * @brief Compute the register ranges to read for a set of fields.
+ *
+ * The ranges come from the field table in STC3115RegisterMap.h; stc3115SpanCount(), stc3115SpanStart() and
+ * stc3115SpanLength() give the same result at compile time for a constant set of fields.
+ *
+ * @param fields combination of STC3115_FIELD_* flags
+ * @param spans array of STC3115_FIELD_COUNT entries that will hold the ranges
+ * @return uint8_t number of ranges
+ */
+uint8_t STC3115::computeReadSpans(uint8_t fields, STC3115ReadSpan* spans) {
+    fields &= STC3115_FIELD_ALL;
+
+    uint8_t count = stc3115SpanCount(fields);
+    for (uint8_t i = 0; i < count; i++) {
+        spans[i].Start = stc3115SpanStart(fields, i);
+        spans[i].Length = stc3115SpanLength(fields, i);
+    }
+
+    return count;
+}
+
 /**
  * @brief Convert measurement data with given factor
  *
@@ -452,10 +552,7 @@ bool STC3115::readBatteryData() {
  * @return int
  */
 int STC3115::convert(short value, unsigned short factor) {
-    int v = (static_cast<long>(value) * factor) >> 11;
-    v = (v + 1) / 2;
-
-    return v;
+    return stc3115Convert(value, factor);
 }
 
 /**
@@ -509,100 +606,421 @@ bool STC3115::stop() {
 /**
  * @brief Gradually update battery status on the internal structure & RAM. This function should be called inside loop.
  *
+ * Completes the update cycle in one call, including any recovery left over by a budgeted run() call.
  */
 void STC3115::run() {
-    int status = getStatus();
-    if (status < 0) {
-        return;
-    }
+    run(0, 0);
+}
 
-    batteryData.StatusWord = status;
+/**
+ * @brief Advance the update cycle without exceeding a per-call budget.
+ *
+ * The cycle is split into steps of at most STC3115_RUN_MAX_STEP_TRANSACTIONS bus transactions; recovery and
+ * reprogramming after a gauge reset take one step per register write. A step is only started when its worst-case
+ * cost still fits the remaining budget, except for the first step of a call, which always runs so the cycle makes
+ * progress. The time cost of a step is estimated from the slowest transaction observed so far. Measurements are
+ * published only when a cycle completes, so readers never see a half-updated set; an abandoned cycle publishes
+ * nothing, which getSnapshotVersion() tells apart.
+ *
+ * @param maxTransactions maximum number of bus transactions in this call, 0 for no limit
+ * @param maxMicros maximum time spent in this call in microseconds, 0 for no limit
+ * @return true if the update cycle completed in this call, or was abandoned because the gauge did not answer the
+ * status read; either way the next call starts a new cycle
+ * @return false if work is left for the next call
+ */
+bool STC3115::run(uint16_t maxTransactions, uint32_t maxMicros) {
+    unsigned long start = micros();
+    uint16_t startCount = getTransactionCount();
+    bool completed = false;
+    bool first = true;
+
+    while (!completed) {
+        uint8_t cost = getStepCost(static_cast<STC3115RunStep>(cycleStep));
+        if (!first) {
+            uint16_t used = getTransactionCount() - startCount;
+            if (maxTransactions != 0 && used + cost > maxTransactions) {
+                break;
+            }
 
-    readRAMData();
-    if ((ramData.reg.TestWord != RAM_TESTWORD) || calculateCRC8RAM(ramData.db, STC3115_RAM_SIZE) != 0) {
-        initRAM();
-        ramData.reg.State = STC3115_INIT;
+            if (maxMicros != 0 && (micros() - start) + static_cast<unsigned long>(cost) * worstTransactionTime > maxMicros) {
+                break;
+            }
+        }
+
+        first = false;
+
+        uint16_t stepCount = getTransactionCount();
+        unsigned long stepStart = micros();
+        completed = runStep();
+
+        uint16_t transactions = getTransactionCount() - stepCount;
+        if (transactions > 0) {
+            unsigned long perTransaction = (micros() - stepStart + transactions - 1) / transactions;
+            if (perTransaction > worstTransactionTime) {
+                worstTransactionTime = perTransaction;
+            }
+        }
     }
 
-    if ((batteryData.StatusWord & (static_cast<int>(STC3115_BATFAIL) << 8)) != 0) {
-        batteryData.Presence = 0;
-        reset();
+    unsigned long elapsed = micros() - start;
+    if (elapsed > worstCaseTime) {
+        worstCaseTime = elapsed;
+    }
 
-        return;
+    return completed;
+}
+
+/**
+ * @brief Execute the pending step of the update cycle and select the next one.
+ *
+ * @return true if the update cycle completed or was abandoned, and the next step starts a new cycle
+ * @return false otherwise
+ */
+bool STC3115::runStep() {
+    switch (cycleStep) {
+    case STC3115_STEP_STATUS: {
+        int status = getStatus();
+        if (status < 0) {
+            return true;
+        }
+
+        batteryData.StatusWord = status;
+
+        if ((status & (static_cast<int>(STC3115_BATFAIL | STC3115_PORDET) << 8)) != 0 || (status & STC3115_GG_RUN) == 0) {
+            invalidateRegisterCache();
+        }
+
+        cycleStep = STC3115_STEP_RAM;
+        return false;
     }
+    case STC3115_STEP_RAM:
+        readRAMData();
+        if ((ramData.reg.TestWord != RAM_TESTWORD) || calculateCRC8RAM(ramData.db, STC3115_RAM_SIZE) != 0) {
+            initRAM();
+            ramData.reg.State = STC3115_INIT;
+        } else {
+            loadTunedConfig();
+        }
 
-    if ((batteryData.StatusWord & STC3115_GG_RUN) == 0) {
+        if ((batteryData.StatusWord & (static_cast<int>(STC3115_BATFAIL) << 8)) != 0) {
+            cycleStep = STC3115_STEP_RESET;
+        } else if ((batteryData.StatusWord & STC3115_GG_RUN) == 0) {
+            cycleStep = STC3115_STEP_RECOVER;
+        } else {
+            cycleStep = STC3115_STEP_MEASURE;
+        }
+
+        return false;
+    case STC3115_STEP_RESET:
+        batteryData.Presence = 0;
+        reset();
+        resyncTrackers();
+        publishSnapshot();
+#if STC3115_ENABLE_EVENTS
+        events.evaluate(batteryData, ramData.reg.State);
+#endif
+
+        cycleStep = STC3115_STEP_STATUS;
+        return true;
+    case STC3115_STEP_RECOVER:
+        resumeRegister = 0;
         if (ramData.reg.State == STC3115_RUNNING || ramData.reg.State == STC3115_POWERDN) {
-            restore();
+            resumeRegister = STC3115_REG_SOC_L;
+            resumeValue = ramData.reg.HRSOC;
         } else {
-            startup();
+            uint8_t registerDataWord[2] = {0};
+            readRegisterRegion(registerDataWord, STC3115_REG_OCV_L, 2);
+            int ocv = registerDataWord[0] | (registerDataWord[1] << 8);
+
+            if (ocv < 6000) {
+                writeRegisterInt(STC3115_REG_SOC_L, 0);
+            } else {
+                resumeRegister = STC3115_REG_OCV_L;
+                resumeValue = ocv;
+            }
+        }
+
+        programStep = 0;
+        cycleStep = STC3115_STEP_PROGRAM;
+        return false;
+    case STC3115_STEP_PROGRAM:
+        programParameter(programStep);
+        programStep++;
+        if (programStep >= STC3115_PROGRAM_STEPS) {
+            cycleStep = STC3115_STEP_RESUME;
+        }
+
+        return false;
+    case STC3115_STEP_RESUME:
+        if (resumeRegister != 0) {
+            writeRegisterInt(resumeRegister, resumeValue);
         }
 
         ramData.reg.State = STC3115_INIT;
-    }
+        resyncTrackers();
+        startInit();
 
-    if (!readBatteryData()) {
-        return;
-    }
+        cycleStep = STC3115_STEP_MEASURE;
+        return false;
+    case STC3115_STEP_MEASURE:
+        if (!readBatteryData()) {
+            cycleStep = STC3115_STEP_STATUS;
+            return true;
+        }
+
+        if (ramData.reg.State == STC3115_INIT) {
+            if (batteryData.ConvCounter > VCOUNT) {
+                ramData.reg.State = STC3115_RUNNING;
+                batteryData.Presence = 1;
+            }
+        }
+
+        computeBatteryData();
+
+        cycleStep = STC3115_STEP_TRACK;
+        return false;
+    case STC3115_STEP_TRACK:
+#if STC3115_ENABLE_ENERGY
+        if (ramData.reg.State == STC3115_RUNNING) {
+            energy.update(batteryData);
+        } else {
+            energy.resync();
+        }
+#endif
+#if STC3115_ENABLE_DRIFT
+        if (ramData.reg.State == STC3115_RUNNING) {
+            drift.update(*this, batteryData);
+        }
+#endif
+#if STC3115_ENABLE_HEALTH
+        if (ramData.reg.State == STC3115_RUNNING) {
+            health.update(batteryData);
+        }
+#endif
 
-    if (ramData.reg.State == STC3115_INIT) {
-        if (batteryData.ConvCounter > VCOUNT) {
-            ramData.reg.State = STC3115_RUNNING;
-            batteryData.Presence = 1;
+        cycleStep = STC3115_STEP_TUNE;
+        return false;
+    case STC3115_STEP_TUNE:
+#if STC3115_ENABLE_RINT
+        if (ramData.reg.State == STC3115_RUNNING) {
+            tuneVMConf();
+        }
+#endif
+#if STC3115_ENABLE_CHARGE_PHASE
+        if (ramData.reg.State == STC3115_RUNNING) {
+            calibrateFullCharge();
         }
+#endif
+
+        cycleStep = STC3115_STEP_STORE;
+        return false;
+    case STC3115_STEP_STORE:
+    default:
+        ramData.reg.HRSOC = batteryData.HRSOC;
+        ramData.reg.SOC = (batteryData.SOC + 5) / 10;
+        updateRAMCRC8();
+        writeRAMData();
+
+#if STC3115_ENABLE_FAST_FIRST_READING
+        if (firstSamplePending && (batteryData.Provisional != 0 || ramData.reg.State == STC3115_RUNNING)) {
+            firstSampleTime = millis() - initTime;
+            firstSamplePending = false;
+        }
+#endif
+
+        publishSnapshot();
+#if STC3115_ENABLE_EVENTS
+        events.evaluate(batteryData, ramData.reg.State);
+#endif
+
+        cycleStep = STC3115_STEP_STATUS;
+        return true;
     }
+}
 
+/**
+ * @brief Get the worst-case number of bus transactions of an update cycle step
+ *
+ * @param step step of the update cycle
+ * @return uint8_t
+ */
+uint8_t STC3115::getStepCost(STC3115RunStep step) {
+    switch (step) {
+    case STC3115_STEP_STATUS:
+    case STC3115_STEP_RESET:
+    case STC3115_STEP_RECOVER:
+    case STC3115_STEP_MEASURE:
+        return 2;
+    case STC3115_STEP_TRACK:
+        return STC3115_RUN_MAX_STEP_TRANSACTIONS;
+    case STC3115_STEP_TUNE:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Derive SOC corrections, remaining charge and remaining time from a fresh measurement set.
+ *
+ */
+void STC3115::computeBatteryData() {
     if (ramData.reg.State != STC3115_RUNNING) {
-        batteryData.ChargeValue = config.CNom * batteryData.SOC / MAX_SOC;
+#if STC3115_ENABLE_FAST_FIRST_READING
+        if (fastFirstReading) {
+            computeProvisionalData();
+            return;
+        }
+#endif
+
+        batteryData.Provisional = 0;
+        batteryData.ChargeValue = computeChargeValue();
         batteryData.Current = 0;
         batteryData.Temperature = 250;
         batteryData.RemTime = -1;
-    } else {
-        if (batteryData.Voltage < APP_CUTOFF_VOLTAGE) {
-            batteryData.SOC = 0;
-        } else if (batteryData.Voltage < (APP_CUTOFF_VOLTAGE + VOLTAGE_SECURITY_RANGE)) {
-            batteryData.SOC = batteryData.SOC * (batteryData.Voltage - APP_CUTOFF_VOLTAGE) / VOLTAGE_SECURITY_RANGE;
-        }
+        return;
+    }
 
-        batteryData.ChargeValue = config.CNom * batteryData.SOC / MAX_SOC;
-        if ((batteryData.StatusWord & STC3115_VMODE) == 0) {
-            if ((batteryData.StatusWord & STC3115_VMODE) == 0) {
-                if (batteryData.Current > APP_EOC_CURRENT && batteryData.SOC > 990) {
-                    batteryData.SOC = 990;
-                    writeRegisterInt(STC3115_REG_SOC_L, 50688);
-                }
-            }
+    batteryData.Provisional = 0;
+    if (batteryData.Voltage < APP_CUTOFF_VOLTAGE) {
+        batteryData.SOC = 0;
+    } else if (batteryData.Voltage < (APP_CUTOFF_VOLTAGE + VOLTAGE_SECURITY_RANGE)) {
+        batteryData.SOC = batteryData.SOC * (batteryData.Voltage - APP_CUTOFF_VOLTAGE) / VOLTAGE_SECURITY_RANGE;
+    }
 
-            if (batteryData.Current < 0) {
-                batteryData.RemTime = (batteryData.RemTime * 4 + batteryData.ChargeValue / batteryData.Current * 60) / 5;
-                if (batteryData.RemTime < 0) {
-                    batteryData.RemTime = -1;
-                }
-            } else {
-                batteryData.RemTime = -1;
+    batteryData.ChargeValue = computeChargeValue();
+#if STC3115_ENABLE_CHARGE_PHASE
+    chargePhase.update(batteryData);
+    if (chargePhase.isCharging() && batteryData.SOC > 990) {
+        batteryData.SOC = 990;
+    }
+#endif
+
+    if ((batteryData.StatusWord & STC3115_VMODE) == 0) {
+#if !STC3115_ENABLE_CHARGE_PHASE
+        if (batteryData.Current > APP_EOC_CURRENT && batteryData.SOC > 990) {
+            batteryData.SOC = 990;
+            writeRegisterInt(STC3115_REG_SOC_L, 50688);
+        }
+#endif
+
+        if (batteryData.Current < 0) {
+            long remTime = (static_cast<long>(batteryData.RemTime) * 4 + static_cast<long>(batteryData.ChargeValue) * 60 / -batteryData.Current) / 5;
+            if (remTime < 0) {
+                remTime = -1;
+            } else if (remTime > 0x7fff) {
+                remTime = 0x7fff;
             }
+
+            batteryData.RemTime = remTime;
         } else {
-            batteryData.Current = 0;
             batteryData.RemTime = -1;
         }
+    } else {
+        batteryData.Current = 0;
+        batteryData.RemTime = -1;
+    }
 
-        if (batteryData.SOC > 1000) {
-            batteryData.SOC = MAX_SOC;
-        }
+    if (batteryData.SOC > 1000) {
+        batteryData.SOC = MAX_SOC;
+    }
 
-        if (batteryData.SOC < 0) {
-            batteryData.SOC = 0;
-        }
+    if (batteryData.SOC < 0) {
+        batteryData.SOC = 0;
     }
+}
 
-    ramData.reg.HRSOC = batteryData.HRSOC;
-    ramData.reg.SOC = (batteryData.SOC + 5) / 10;
-    updateRAMCRC8();
-    writeRAMData();
+/**
+ * @brief Estimate the measurement set of a gauge that has not converged yet.
+ *
+ * Once the gauge finished its first conversion, the open-circuit voltage is estimated from the live voltage and
+ * current and the internal resistance programmed in VM_CNF; before that, the OCV register is used. The state of
+ * charge is read from the OCV curve and the set is flagged as provisional.
+ */
+void STC3115::computeProvisionalData() {
+#if STC3115_ENABLE_FAST_FIRST_READING
+    int ocv = batteryData.OCV;
+    if (batteryData.ConvCounter > 0) {
+        long resistance = STC3115RintEstimator::fromVMConf(config.CNom, config.VMConf);
+        ocv = batteryData.Voltage - static_cast<long>(batteryData.Current) * resistance / 1000;
+    } else {
+        batteryData.Voltage = ocv;
+        batteryData.Current = 0;
+        batteryData.Temperature = 250;
+    }
 
-    if (ramData.reg.State == STC3115_RUNNING) {
-        return;
+    batteryData.SOC = ocvCurve.getSOC(ocv);
+    batteryData.ChargeValue = computeChargeValue();
+    if (batteryData.Current < 0) {
+        long remTime = static_cast<long>(batteryData.ChargeValue) * 60 / -batteryData.Current;
+        batteryData.RemTime = remTime > 0x7fff ? 0x7fff : remTime;
+    } else {
+        batteryData.RemTime = -1;
     }
+
+    batteryData.Provisional = 1;
+#endif
+}
+
+/**
+ * @brief Start measuring the time to the first valid measurement set after the gauge was (re)started.
+ *
+ */
+void STC3115::startInit() {
+#if STC3115_ENABLE_FAST_FIRST_READING
+    initTime = millis();
+    firstSamplePending = true;
+#endif
+}
+
+/**
+ * @brief Restart the trackers that follow the conversion counter after the gauge was restarted.
+ *
+ */
+void STC3115::resyncTrackers() {
+#if STC3115_ENABLE_ENERGY
+    energy.resync();
+#endif
+#if STC3115_ENABLE_DRIFT
+    drift.resync();
+#endif
+#if STC3115_ENABLE_RINT
+    rint.resync();
+#endif
+#if STC3115_ENABLE_CHARGE_PHASE
+    chargePhase.resync();
+#endif
+#if STC3115_ENABLE_HEALTH
+    health.resync();
+#endif
+}
+
+/**
+ * @brief Check whether a budgeted run() call left the update cycle unfinished
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115::isRunPending() {
+    return cycleStep != STC3115_STEP_STATUS;
+}
+
+/**
+ * @brief Get the longest time a run() call took since the last resetWorstCaseTime()
+ *
+ * @return uint32_t time in microseconds
+ */
+uint32_t STC3115::getWorstCaseTime() {
+    return worstCaseTime;
+}
+
+/**
+ * @brief Forget the observed worst-case times, e.g. after the application finished starting up.
+ *
+ */
+void STC3115::resetWorstCaseTime() {
+    worstCaseTime = 0;
+    worstTransactionTime = 0;
 }
 
 /**
@@ -646,14 +1064,410 @@ bool STC3115::isBatteryDetected() {
     return batteryData.Presence == 1;
 }
 
+/**
+ * @brief Copy the measurement set published by the last run() call.
+ *
+ * Unlike the individual getters, this is safe to call from any task or core while another task is inside run().
+ * It never blocks; it only fails if run() published STC3115_SNAPSHOT_RETRIES times during the copy.
+ * With STC3115_ENABLE_SNAPSHOT set to 0 it copies the live measurement set and is only safe from the task that calls run().
+ *
+ * @param output pointer to the structure that will hold the measurement set
+ * @param version optional pointer that receives the number of snapshots published so far
+ * @return true if a consistent copy was made
+ * @return false otherwise
+ */
+bool STC3115::getSnapshot(STC3115BatteryData* output, stc3115_seq_t* version) {
+#if STC3115_ENABLE_SNAPSHOT
+    return snapshot.read(output, version, STC3115_SNAPSHOT_RETRIES);
+#else
+    *output = batteryData;
+    if (version != NULL) {
+        *version = snapshotVersion;
+    }
+
+    return true;
+#endif
+}
+
+/**
+ * @brief Get the number of snapshots published so far. Readers can compare it to detect a new measurement set.
+ * The count wraps past 0, so 0 always means that nothing was published yet.
+ *
+ * @return stc3115_seq_t
+ */
+stc3115_seq_t STC3115::getSnapshotVersion() {
+#if STC3115_ENABLE_SNAPSHOT
+    return snapshot.getVersion();
+#else
+    return snapshotVersion;
+#endif
+}
+
+/**
+ * @brief Register a callback that run() invokes when a kind of change is observed.
+ *
+ * @param type kind of change
+ * @param callback function called from the task that calls run()
+ * @param context pointer passed back to the callback
+ * @param threshold SOC threshold in 0.1% (STC3115_EVENT_SOC_CROSSING only)
+ * @param hysteresis SOC hysteresis in 0.1% (STC3115_EVENT_SOC_CROSSING only)
+ * @return int subscription ID, or -1 if STC3115_MAX_SUBSCRIPTIONS subscriptions exist
+ */
+#if STC3115_ENABLE_EVENTS
+int STC3115::subscribe(STC3115EventType type, STC3115EventCallback callback, void* context, int threshold, int hysteresis) {
+    return events.subscribe(type, callback, context, threshold, hysteresis);
+}
+
+/**
+ * @brief Remove a subscription
+ *
+ * @param id subscription ID returned by subscribe()
+ * @return true
+ * @return false
+ */
+bool STC3115::unsubscribe(int id) {
+    return events.unsubscribe(id);
+}
+#endif
+
+/**
+ * @brief Get the charge and energy throughput integrated by run()
+ *
+ * @return STC3115EnergyCounter&
+ */
+#if STC3115_ENABLE_ENERGY
+STC3115EnergyCounter& STC3115::getEnergyCounter() {
+    return energy;
+}
+#endif
+
+/**
+ * @brief Get the voltage, current and temperature statistics updated by readBatteryData()
+ *
+ * @return STC3115Statistics&
+ */
+#if STC3115_ENABLE_STATISTICS
+STC3115Statistics& STC3115::getStatistics() {
+    return statistics;
+}
+#endif
+
+/**
+ * @brief Get the CC/VM adjustment diagnostics. Sampling is off until getDriftMonitor().enable() is called.
+ *
+ * @return STC3115DriftMonitor&
+ */
+#if STC3115_ENABLE_DRIFT
+STC3115DriftMonitor& STC3115::getDriftMonitor() {
+    return drift;
+}
+#endif
+
+/**
+ * @brief Select the capacity-vs-temperature table applied to the remaining charge and remaining time.
+ *
+ * @param chemistry battery chemistry, STC3115_CHEMISTRY_NONE to use the nominal capacity at any temperature
+ */
+#if STC3115_ENABLE_DERATING || STC3115_ENABLE_FAST_FIRST_READING
+void STC3115::setChemistry(STC3115Chemistry chemistry) {
+#if STC3115_ENABLE_DERATING
+    derating.setChemistry(chemistry);
+#endif
+#if STC3115_ENABLE_FAST_FIRST_READING
+    ocvCurve.setChemistry(chemistry);
+#endif
+}
+#endif
+
+#if STC3115_ENABLE_FAST_FIRST_READING
+/**
+ * @brief Report provisional estimates while the gauge is converging instead of placeholder values.
+ *
+ * Until the conversion counter passes VCOUNT, run() derives SOC, remaining charge and remaining time from the
+ * open-circuit voltage curve and reports the live voltage, current and temperature. Such sets have Provisional
+ * set to 1. Energy integration and SOC crossing events skip them; statistics only use the measured values.
+ */
+void STC3115::enableFastFirstReading() {
+    fastFirstReading = true;
+}
+
+/**
+ * @brief Report placeholder values while the gauge is converging.
+ *
+ */
+void STC3115::disableFastFirstReading() {
+    fastFirstReading = false;
+}
+
+/**
+ * @brief Use a characterized OCV curve of the cell for provisional estimates instead of the chemistry default.
+ *
+ * @param curve points in increasing voltage, in flash on AVR
+ * @param size number of points
+ */
+void STC3115::setOCVCurve(const STC3115OCVPoint* curve, uint8_t size) {
+    ocvCurve.setCurve(curve, size);
+}
+
+/**
+ * @brief Get the time from the last start of the gauge to the first published set that was provisional or converged.
+ *
+ * @return long time in milliseconds, or -1 while no such set was published yet
+ */
+long STC3115::getTimeToFirstSample() {
+    if (firstSamplePending) {
+        return -1;
+    }
+
+    return firstSampleTime;
+}
+#endif
+
+/**
+ * @brief Get the internal resistance estimator. VM_CNF is only retuned after getRintEstimator().enable() is called.
+ *
+ * @return STC3115RintEstimator&
+ */
+#if STC3115_ENABLE_RINT
+STC3115RintEstimator& STC3115::getRintEstimator() {
+    return rint;
+}
+#endif
+
+/**
+ * @brief Get the charge phase detector, e.g. to read the phase and its duration or to change its thresholds.
+ *
+ * @return STC3115ChargePhaseDetector&
+ */
+#if STC3115_ENABLE_CHARGE_PHASE
+STC3115ChargePhaseDetector& STC3115::getChargePhaseDetector() {
+    return chargePhase;
+}
+#endif
+
+/**
+ * @brief Get the state-of-health estimator. Once it has measured the capacity, remaining charge and remaining time
+ * are computed from the measured capacity instead of the nominal one.
+ *
+ * @return STC3115HealthEstimator&
+ */
+#if STC3115_ENABLE_HEALTH
+STC3115HealthEstimator& STC3115::getHealthEstimator() {
+    return health;
+}
+#endif
+
+/**
+ * @brief Get how often run() is worth calling in the current charge phase. Without the charge phase detector,
+ * this is the conversion period of the gauge.
+ *
+ * @return uint32_t interval in milliseconds
+ */
+uint32_t STC3115::getRecommendedPollInterval() {
+#if STC3115_ENABLE_CHARGE_PHASE
+    return chargePhase.getRecommendedInterval();
+#else
+    return (batteryData.StatusWord & STC3115_VMODE) != 0 ? STC3115_CONV_PERIOD_VM_MS : STC3115_CONV_PERIOD_MIXED_MS;
+#endif
+}
+
+/**
+ * @brief Get the usable capacity the remaining charge is computed from: the one measured by the state-of-health
+ * estimator if enabled, the nominal one otherwise.
+ *
+ * @return int capacity in mAh
+ */
+int STC3115::getCapacity() {
+#if STC3115_ENABLE_HEALTH
+    return health.getCapacity();
+#else
+    return config.CNom;
+#endif
+}
+
+/**
+ * @brief Copy the driver state that should survive a power cycle of the host, e.g. to EEPROM or NVS.
+ *
+ * @param state pointer to the structure that will hold the state
+ */
+void STC3115::exportState(STC3115PersistentState* state) {
+    state->Version = STC3115_STATE_VERSION;
+    state->Size = sizeof(STC3115PersistentState);
+#if STC3115_ENABLE_ENERGY
+    energy.exportState(&state->Energy);
+#else
+    memset(&state->Energy, 0, sizeof(state->Energy));
+#endif
+#if STC3115_ENABLE_HEALTH
+    health.exportState(&state->Health);
+#else
+    memset(&state->Health, 0, sizeof(state->Health));
+#endif
+}
+
+/**
+ * @brief Restore a state saved by exportState()
+ *
+ * @param state saved state
+ * @return true
+ * @return false if the state was saved by an incompatible driver version
+ */
+bool STC3115::importState(const STC3115PersistentState* state) {
+    if (state->Version != STC3115_STATE_VERSION || state->Size != sizeof(STC3115PersistentState)) {
+        return false;
+    }
+
+#if STC3115_ENABLE_ENERGY
+    energy.importState(state->Energy);
+#endif
+#if STC3115_ENABLE_HEALTH
+    health.importState(state->Health);
+#endif
+    return true;
+}
+
+/**
+ * @brief Publish the current measurement set to snapshot readers.
+ *
+ */
+void STC3115::publishSnapshot() {
+#if STC3115_ENABLE_SNAPSHOT
+    snapshot.publish(batteryData);
+#else
+    snapshotVersion++;
+    if (snapshotVersion == 0) {
+        snapshotVersion = 1;
+    }
+#endif
+}
+
+/**
+ * @brief Compute the remaining charge from the usable capacity and SOC, derated for temperature if enabled.
+ *
+ * @return int remaining charge in mAh
+ */
+int STC3115::computeChargeValue() {
+    int chargeValue = static_cast<long>(getCapacity()) * batteryData.SOC / MAX_SOC;
+#if STC3115_ENABLE_DERATING
+    return derating.apply(chargeValue, batteryData.Temperature);
+#else
+    return chargeValue;
+#endif
+}
+
+/**
+ * @brief Set the SOC to full once the charge phase detector reports the end of a charge.
+ *
+ * During the charge the reported SOC is held at 99%; the gauge itself is only corrected here, once per charge.
+ */
+void STC3115::calibrateFullCharge() {
+#if STC3115_ENABLE_CHARGE_PHASE
+    if (!chargePhase.takeCalibration()) {
+        return;
+    }
+
+    if (writeRegisterInt(STC3115_REG_SOC_L, MAX_HRSOC)) {
+        STC3115_DEBUG_PRINTLN("[DBG] Full charge calibration");
+        batteryData.HRSOC = MAX_HRSOC;
+        batteryData.SOC = MAX_SOC;
+        batteryData.ChargeValue = computeChargeValue();
+    }
+#endif
+}
+
+/**
+ * @brief Feed the latest conversion to the resistance estimator and rewrite VM_CNF when it proposes a new value.
+ *
+ * The new value is kept in the configuration and in the RAM image. begin() and run() take it back from a valid RAM
+ * image through loadTunedConfig(), so the gauge is reprogrammed with it after a host or gauge reset.
+ */
+void STC3115::tuneVMConf() {
+#if STC3115_ENABLE_RINT
+    rint.update(batteryData);
+
+    int vmConf;
+    if (!rint.getAdjustment(config.CNom, config.VMConf, &vmConf)) {
+        return;
+    }
+
+    if (writeRegisterInt(STC3115_REG_VM_CNF_L, vmConf)) {
+        STC3115_DEBUG_PRINT("[DBG] VMConf: ");
+        STC3115_DEBUG_PRINTLN(vmConf);
+        config.VMConf = vmConf;
+        ramData.reg.VMConf = vmConf;
+    }
+#endif
+}
+
 void STC3115::enableDebugging(Stream* stream) {
+#if STC3115_ENABLE_DEBUG
     this->debugStream = stream;
     this->debugEnabled = true;
+#else
+    (void)stream;
+#endif
 }
 
 void STC3115::disableDebugging() {
+#if STC3115_ENABLE_DEBUG
     this->debugEnabled = false;
     this->debugStream = NULL;
+#endif
+}
+
+/**
+ * @brief Report the RAM used by one gauge instance in the current build profile.
+ *
+ * Flash usage depends on the toolchain and on which methods the sketch calls; compare the size output of
+ * builds with and without a feature to measure it.
+ *
+ * @param footprint pointer to the structure that will hold the sizes
+ */
+void STC3115::getFootprint(STC3115Footprint* footprint) {
+    memset(footprint, 0, sizeof(STC3115Footprint));
+#if STC3115_ENABLE_REGISTER_CACHE
+    footprint->RegisterCache = sizeof(cacheEnabled) + sizeof(shadow) + sizeof(shadowValid);
+#endif
+#if STC3115_ENABLE_SNAPSHOT
+    footprint->Snapshot = sizeof(snapshot);
+#else
+    footprint->Snapshot = sizeof(snapshotVersion);
+#endif
+#if STC3115_ENABLE_EVENTS
+    footprint->Events = sizeof(events);
+#endif
+#if STC3115_ENABLE_ENERGY
+    footprint->Energy = sizeof(energy);
+#endif
+#if STC3115_ENABLE_STATISTICS
+    footprint->Statistics = sizeof(statistics);
+#endif
+#if STC3115_ENABLE_DRIFT
+    footprint->Drift = sizeof(drift);
+#endif
+#if STC3115_ENABLE_DERATING
+    footprint->Derating = sizeof(derating);
+#endif
+#if STC3115_ENABLE_RINT
+    footprint->Rint = sizeof(rint);
+#endif
+#if STC3115_ENABLE_FAST_FIRST_READING
+    footprint->FastFirstReading = sizeof(ocvCurve) + sizeof(fastFirstReading) + sizeof(firstSamplePending) + sizeof(initTime)
+        + sizeof(firstSampleTime);
+#endif
+#if STC3115_ENABLE_CHARGE_PHASE
+    footprint->ChargePhase = sizeof(chargePhase);
+#endif
+#if STC3115_ENABLE_HEALTH
+    footprint->Health = sizeof(health);
+#endif
+#if STC3115_ENABLE_DEBUG
+    footprint->Debug = sizeof(debugEnabled) + sizeof(debugStream);
+#endif
+    footprint->Total = sizeof(STC3115);
+    footprint->Core = footprint->Total - footprint->RegisterCache - footprint->Snapshot - footprint->Events - footprint->Energy
+        - footprint->Statistics - footprint->Drift - footprint->Derating - footprint->Rint - footprint->FastFirstReading
+        - footprint->ChargePhase - footprint->Health - footprint->Debug;
 }
 
 
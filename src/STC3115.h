@@ -1,11 +1,23 @@
 #ifndef STC3115_DRIVER_COMPONENT_H
 #define STC3115_DRIVER_COMPONENT_H
 
-#include <Arduino.h>
+#include "STC3115_platform.h"
+#include "STC3115_config.h"
 #include "STC3115_constants.h"
 #include "STC3115_types.h"
 #include "STC3115_registers.h"
+#include "STC3115RegisterMap.h"
 #include "STC3115I2CCore.h"
+#include "STC3115SeqLock.h"
+#include "STC3115Events.h"
+#include "STC3115Energy.h"
+#include "STC3115Statistics.h"
+#include "STC3115Drift.h"
+#include "STC3115Derating.h"
+#include "STC3115Resistance.h"
+#include "STC3115OCVCurve.h"
+#include "STC3115ChargePhase.h"
+#include "STC3115Health.h"
 
 #define BATT_CAPACITY 610
 #define BATT_RINT 200
@@ -37,21 +49,67 @@ public:
 
     void enableDebugging(Stream* stream = NULL);
     void disableDebugging();
+    static void getFootprint(STC3115Footprint* footprint);
 
     int getRunningCounter();
-    bool readBatteryData();
+    bool readBatteryData(uint8_t fields = STC3115_FIELD_ALL);
     static int convert(short value, unsigned short factor);
+    static uint8_t computeReadSpans(uint8_t fields, STC3115ReadSpan* spans);
 
     bool reset();
     bool stop();
     bool powerDown();
 
     void run();
+    bool run(uint16_t maxTransactions, uint32_t maxMicros = 0);
+    bool isRunPending();
+    uint32_t getWorstCaseTime();
+    uint32_t getRecommendedPollInterval();
+    int getCapacity();
+    void resetWorstCaseTime();
     bool startPowerSavingMode();
     bool stopPowerSavingMode();
 
     bool isBatteryDetected();
 
+    bool getSnapshot(STC3115BatteryData* output, stc3115_seq_t* version = NULL);
+    stc3115_seq_t getSnapshotVersion();
+
+#if STC3115_ENABLE_EVENTS
+    int subscribe(STC3115EventType type, STC3115EventCallback callback, void* context = NULL, int threshold = 0, int hysteresis = 0);
+    bool unsubscribe(int id);
+#endif
+
+#if STC3115_ENABLE_ENERGY
+    STC3115EnergyCounter& getEnergyCounter();
+#endif
+#if STC3115_ENABLE_STATISTICS
+    STC3115Statistics& getStatistics();
+#endif
+#if STC3115_ENABLE_DRIFT
+    STC3115DriftMonitor& getDriftMonitor();
+#endif
+#if STC3115_ENABLE_DERATING || STC3115_ENABLE_FAST_FIRST_READING
+    void setChemistry(STC3115Chemistry chemistry);
+#endif
+#if STC3115_ENABLE_FAST_FIRST_READING
+    void enableFastFirstReading();
+    void disableFastFirstReading();
+    void setOCVCurve(const STC3115OCVPoint* curve, uint8_t size);
+    long getTimeToFirstSample();
+#endif
+#if STC3115_ENABLE_RINT
+    STC3115RintEstimator& getRintEstimator();
+#endif
+#if STC3115_ENABLE_CHARGE_PHASE
+    STC3115ChargePhaseDetector& getChargePhaseDetector();
+#endif
+#if STC3115_ENABLE_HEALTH
+    STC3115HealthEstimator& getHealthEstimator();
+#endif
+    void exportState(STC3115PersistentState* state);
+    bool importState(const STC3115PersistentState* state);
+
     STC3115ConfigData config;
 protected:
     void initConfig(int battCapacity, int rSense);
@@ -62,13 +120,75 @@ protected:
     bool writeRAMData();
     bool startup();
     bool restore();
+    void loadTunedConfig();
     void setParamAndRun();
+    bool programParameter(uint8_t step);
+    bool runStep();
+    static uint8_t getStepCost(STC3115RunStep step);
+    void computeBatteryData();
+    void resyncTrackers();
+    void computeProvisionalData();
+    void startInit();
+    void calibrateFullCharge();
+    void publishSnapshot();
+    int computeChargeValue();
+    void tuneVMConf();
 
     STC3115BatteryData batteryData;
     STC3115RAMData ramData;
+    uint8_t cycleStep;
+    uint8_t programStep;
+    uint8_t resumeRegister;
+    uint16_t resumeValue;
+    uint32_t worstCaseTime;
+    uint32_t worstTransactionTime;
+#if STC3115_ENABLE_SNAPSHOT
+    STC3115SeqLock<STC3115BatteryData> snapshot;
+#else
+    stc3115_seq_t snapshotVersion;
+#endif
+#if STC3115_ENABLE_EVENTS
+    STC3115EventRegistry events;
+#endif
+#if STC3115_ENABLE_ENERGY
+    STC3115EnergyCounter energy;
+#endif
+#if STC3115_ENABLE_STATISTICS
+    STC3115Statistics statistics;
+#endif
+#if STC3115_ENABLE_DRIFT
+    STC3115DriftMonitor drift;
+#endif
+#if STC3115_ENABLE_DERATING
+    STC3115Derating derating;
+#endif
+#if STC3115_ENABLE_RINT
+    STC3115RintEstimator rint;
+#endif
+#if STC3115_ENABLE_CHARGE_PHASE
+    STC3115ChargePhaseDetector chargePhase;
+#endif
+#if STC3115_ENABLE_HEALTH
+    STC3115HealthEstimator health;
+#endif
+#if STC3115_ENABLE_FAST_FIRST_READING
+    STC3115OCVCurve ocvCurve;
+    bool fastFirstReading;
+    bool firstSamplePending;
+    uint32_t initTime;
+    uint32_t firstSampleTime;
+#endif
 
+#if STC3115_ENABLE_DEBUG
     bool debugEnabled;
     Stream* debugStream;
+#endif
 };
 
+#if defined(STC3115_LOW_RAM)
+static_assert(sizeof(STC3115BatteryData) <= STC3115_LOW_RAM_BATTERY_DATA_BUDGET, "STC3115BatteryData exceeds the low-RAM budget");
+static_assert(sizeof(STC3115ConfigData) <= STC3115_LOW_RAM_CONFIG_BUDGET, "STC3115ConfigData exceeds the low-RAM budget");
+static_assert(sizeof(STC3115) <= STC3115_LOW_RAM_GAUGE_BUDGET + 2 * sizeof(void*), "STC3115 exceeds the low-RAM budget");
+#endif
+
 #endif
@@ -0,0 +1,245 @@
+#include "STC3115ChargePhase.h"
+#include "STC3115_constants.h"
+#include "STC3115_registers.h"
+
+STC3115ChargePhaseDetector::STC3115ChargePhaseDetector():
+ phase(STC3115_PHASE_UNKNOWN),
+ pending(STC3115_PHASE_UNKNOWN),
+ pendingCount(0),
+ synced(false),
+ calibrated(false),
+ calibrationPending(false),
+ lastCounter(0),
+ filteredCurrent(0),
+ peakCurrent(0),
+ phaseTime(0),
+ pendingTime(0) {
+    thresholds.RestCurrent = STC3115_PHASE_REST_CURRENT;
+    thresholds.EOCCurrent = STC3115_PHASE_EOC_CURRENT;
+    thresholds.CVVoltage = STC3115_PHASE_CV_VOLTAGE;
+    thresholds.CVTaper = STC3115_PHASE_CV_TAPER;
+    thresholds.Debounce = STC3115_PHASE_DEBOUNCE;
+}
+
+/**
+ * @brief Replace the classification thresholds. The current phase is kept.
+ *
+ * @param thresholds new thresholds; a Debounce of 0 is treated as 1
+ */
+void STC3115ChargePhaseDetector::setThresholds(const STC3115PhaseThresholds& thresholds) {
+    this->thresholds = thresholds;
+    if (this->thresholds.Debounce == 0) {
+        this->thresholds.Debounce = 1;
+    }
+}
+
+/**
+ * @brief Get the classification thresholds
+ *
+ * @return const STC3115PhaseThresholds&
+ */
+const STC3115PhaseThresholds& STC3115ChargePhaseDetector::getThresholds() {
+    return thresholds;
+}
+
+/**
+ * @brief Classify a new conversion and report a phase once it was seen on Debounce consecutive measurement sets.
+ *
+ * Measurement sets of the same conversion are ignored. The filter and the debounce count advance once per set
+ * read, never for conversions that were skipped, so a single outlier cannot switch the phase however sparse the
+ * polling.
+ *
+ * @param data latest measurement set of a running gauge
+ * @return true if the reported phase changed
+ * @return false otherwise
+ */
+bool STC3115ChargePhaseDetector::update(const STC3115BatteryData& data) {
+    if (synced && data.ConvCounter == lastCounter) {
+        return false;
+    }
+
+    uint32_t elapsed = 0;
+    bool voltageMode = (data.StatusWord & STC3115_VMODE) != 0;
+    if (synced) {
+        uint16_t conversions = (data.ConvCounter - lastCounter) & 0xffff;
+        elapsed = static_cast<uint32_t>(conversions) * (voltageMode ? STC3115_CONV_PERIOD_VM_MS : STC3115_CONV_PERIOD_MIXED_MS);
+    } else {
+        filteredCurrent = data.Current;
+    }
+
+    lastCounter = data.ConvCounter;
+    synced = true;
+    phaseTime += elapsed;
+    if (voltageMode) {
+        return false;
+    }
+
+    filteredCurrent += (data.Current - filteredCurrent) / (1 << STC3115_PHASE_FILTER_SHIFT);
+
+    STC3115ChargePhase candidate = classify(data.Voltage, data.Current);
+    if (candidate == STC3115_PHASE_CC || candidate == STC3115_PHASE_CV) {
+        if (filteredCurrent > peakCurrent) {
+            peakCurrent = filteredCurrent;
+        }
+    }
+
+    if (candidate == phase) {
+        pendingCount = 0;
+        return false;
+    }
+
+    if (candidate != pending || pendingCount == 0) {
+        pending = candidate;
+        pendingCount = 0;
+        pendingTime = 0;
+    }
+
+    pendingCount++;
+    pendingTime += elapsed;
+    if (pendingCount < thresholds.Debounce) {
+        return false;
+    }
+
+    phase = candidate;
+    phaseTime = pendingTime;
+    pendingCount = 0;
+
+    if (phase == STC3115_PHASE_REST || phase == STC3115_PHASE_DISCHARGE || phase == STC3115_PHASE_EOC) {
+        peakCurrent = 0;
+    }
+
+    if (phase == STC3115_PHASE_DISCHARGE) {
+        calibrated = false;
+    } else if (phase == STC3115_PHASE_EOC && !calibrated) {
+        calibrated = true;
+        calibrationPending = true;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Skip the conversion gap after the gauge was restarted. The phase is kept.
+ *
+ */
+void STC3115ChargePhaseDetector::resync() {
+    synced = false;
+    pendingCount = 0;
+}
+
+/**
+ * @brief Forget the phase and any pending calibration
+ *
+ */
+void STC3115ChargePhaseDetector::clear() {
+    phase = STC3115_PHASE_UNKNOWN;
+    pending = STC3115_PHASE_UNKNOWN;
+    pendingCount = 0;
+    synced = false;
+    calibrated = false;
+    calibrationPending = false;
+    peakCurrent = 0;
+    phaseTime = 0;
+    pendingTime = 0;
+}
+
+/**
+ * @brief Get the reported phase
+ *
+ * @return STC3115ChargePhase
+ */
+STC3115ChargePhase STC3115ChargePhaseDetector::getPhase() {
+    return phase;
+}
+
+/**
+ * @brief Get the time spent in the reported phase, counted in conversions including the debounce time.
+ *
+ * @return uint32_t duration in milliseconds
+ */
+uint32_t STC3115ChargePhaseDetector::getPhaseDuration() {
+    return phaseTime;
+}
+
+/**
+ * @brief Check whether a charge is in progress and has not reached its end yet
+ *
+ * @return true in the constant current and constant voltage phases
+ * @return false otherwise
+ */
+bool STC3115ChargePhaseDetector::isCharging() {
+    return phase == STC3115_PHASE_CC || phase == STC3115_PHASE_CV;
+}
+
+/**
+ * @brief Take the full-charge calibration requested by the last end of charge. Returns true once per request.
+ *
+ * @return true if the SOC should be set to full now
+ * @return false otherwise
+ */
+bool STC3115ChargePhaseDetector::takeCalibration() {
+    bool requested = calibrationPending;
+    calibrationPending = false;
+
+    return requested;
+}
+
+/**
+ * @brief Get the polling interval suited to the reported phase: fast while the charge is about to end, slow at rest.
+ *
+ * @return uint32_t interval in milliseconds
+ */
+uint32_t STC3115ChargePhaseDetector::getRecommendedInterval() {
+    switch (phase) {
+    case STC3115_PHASE_REST:
+        return STC3115_PHASE_INTERVAL_REST;
+    case STC3115_PHASE_DISCHARGE:
+        return STC3115_PHASE_INTERVAL_DISCHARGE;
+    case STC3115_PHASE_CC:
+        return STC3115_PHASE_INTERVAL_CC;
+    case STC3115_PHASE_EOC:
+        return STC3115_PHASE_INTERVAL_EOC;
+    case STC3115_PHASE_CV:
+    default:
+        return STC3115_PHASE_INTERVAL_CV;
+    }
+}
+
+/**
+ * @brief Classify the latest conversion from the current, the voltage and the reported phase.
+ *
+ * The direction of the current is taken from the latest conversion, so a charger that is unplugged is seen at once
+ * and is not mistaken for a current tapering off. The taper and end of charge are judged on the filtered current,
+ * and only while the voltage stays within STC3115_PHASE_CV_BAND of CVVoltage.
+ *
+ * @param voltage battery voltage in mV
+ * @param current battery current in mA
+ * @return STC3115ChargePhase
+ */
+STC3115ChargePhase STC3115ChargePhaseDetector::classify(int voltage, int current) {
+    if (current < -thresholds.RestCurrent) {
+        return STC3115_PHASE_DISCHARGE;
+    }
+
+    if (current <= thresholds.RestCurrent) {
+        return STC3115_PHASE_REST;
+    }
+
+    if (voltage < thresholds.CVVoltage - STC3115_PHASE_CV_BAND) {
+        return STC3115_PHASE_CC;
+    }
+
+    if (filteredCurrent <= thresholds.EOCCurrent && (phase == STC3115_PHASE_CV || phase == STC3115_PHASE_EOC)) {
+        return STC3115_PHASE_EOC;
+    }
+
+    if (phase == STC3115_PHASE_CV || voltage >= thresholds.CVVoltage) {
+        return STC3115_PHASE_CV;
+    }
+
+    if (peakCurrent > 0 && static_cast<long>(filteredCurrent) * 100 <= static_cast<long>(peakCurrent) * (100 - thresholds.CVTaper)) {
+        return STC3115_PHASE_CV;
+    }
+
+    return STC3115_PHASE_CC;
+}
@@ -0,0 +1,125 @@
+#ifndef STC3115_CHARGE_PHASE_H
+#define STC3115_CHARGE_PHASE_H
+
+#include <stdint.h>
+#include "STC3115_types.h"
+
+#ifndef STC3115_PHASE_REST_CURRENT
+#define STC3115_PHASE_REST_CURRENT 10
+#endif
+
+#ifndef STC3115_PHASE_EOC_CURRENT
+#define STC3115_PHASE_EOC_CURRENT 75
+#endif
+
+#ifndef STC3115_PHASE_CV_VOLTAGE
+#define STC3115_PHASE_CV_VOLTAGE 4150
+#endif
+
+#ifndef STC3115_PHASE_CV_BAND
+#define STC3115_PHASE_CV_BAND 50
+#endif
+
+#ifndef STC3115_PHASE_CV_TAPER
+#define STC3115_PHASE_CV_TAPER 10
+#endif
+
+#ifndef STC3115_PHASE_DEBOUNCE
+#define STC3115_PHASE_DEBOUNCE 3
+#endif
+
+#ifndef STC3115_PHASE_INTERVAL_REST
+#define STC3115_PHASE_INTERVAL_REST 10000
+#endif
+
+#ifndef STC3115_PHASE_INTERVAL_DISCHARGE
+#define STC3115_PHASE_INTERVAL_DISCHARGE 2000
+#endif
+
+#ifndef STC3115_PHASE_INTERVAL_CC
+#define STC3115_PHASE_INTERVAL_CC 2000
+#endif
+
+#ifndef STC3115_PHASE_INTERVAL_CV
+#define STC3115_PHASE_INTERVAL_CV 500
+#endif
+
+#ifndef STC3115_PHASE_INTERVAL_EOC
+#define STC3115_PHASE_INTERVAL_EOC 5000
+#endif
+
+#define STC3115_PHASE_FILTER_SHIFT 2
+
+/**
+ * @brief Phase of the charge cycle
+ *
+ */
+typedef enum {
+    STC3115_PHASE_UNKNOWN = 0,
+    STC3115_PHASE_REST,
+    STC3115_PHASE_DISCHARGE,
+    STC3115_PHASE_CC,
+    STC3115_PHASE_CV,
+    STC3115_PHASE_EOC
+} STC3115ChargePhase;
+
+/**
+ * @brief Thresholds of the charge phase detector.
+ *
+ * Currents are in mA, voltage in mV. CVTaper is the drop of the charge current below its peak, in percent, that
+ * marks the constant voltage phase when the charger regulates slightly below CVVoltage. Debounce is the number of
+ * consecutive measurement sets a new phase has to be seen on before it is reported.
+ */
+typedef struct {
+    int16_t RestCurrent;
+    int16_t EOCCurrent;
+    int16_t CVVoltage;
+    uint8_t CVTaper;
+    uint8_t Debounce;
+} STC3115PhaseThresholds;
+
+/**
+ * @brief Classifies each conversion into a charge phase from the current and voltage trend.
+ *
+ * The current is low-pass filtered and its peak during a charge is kept. A charge is constant current until the
+ * voltage reaches CVVoltage, or comes within STC3115_PHASE_CV_BAND of it while the filtered current falls CVTaper
+ * percent below the peak. It is then constant voltage until the filtered current drops to EOCCurrent. A charge only
+ * ends through the constant voltage phase, and only while the voltage stays near CVVoltage and some current still
+ * flows: a charger that is unplugged, in any phase, makes the current collapse and is reported as rest, not as end
+ * of charge, and an end of charge turns into rest once the charger stops.
+ *
+ * Each end of charge reached after a discharge requests one full-charge calibration, taken with takeCalibration().
+ * Voltage mode reports no current; its conversions only extend the duration of the current phase.
+ */
+class STC3115ChargePhaseDetector {
+public:
+    STC3115ChargePhaseDetector();
+
+    void setThresholds(const STC3115PhaseThresholds& thresholds);
+    const STC3115PhaseThresholds& getThresholds();
+    bool update(const STC3115BatteryData& data);
+    void resync();
+    void clear();
+    STC3115ChargePhase getPhase();
+    uint32_t getPhaseDuration();
+    bool isCharging();
+    bool takeCalibration();
+    uint32_t getRecommendedInterval();
+private:
+    STC3115ChargePhase classify(int voltage, int current);
+
+    STC3115PhaseThresholds thresholds;
+    STC3115ChargePhase phase;
+    STC3115ChargePhase pending;
+    uint8_t pendingCount;
+    bool synced;
+    bool calibrated;
+    bool calibrationPending;
+    int lastCounter;
+    int filteredCurrent;
+    int peakCurrent;
+    uint32_t phaseTime;
+    uint32_t pendingTime;
+};
+
+#endif
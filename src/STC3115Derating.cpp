@@ -0,0 +1,129 @@
+#include "STC3115Derating.h"
+
+static const STC3115DeratingPoint liIonTable[] STC3115_PROGMEM = {
+    STC3115_DERATE_POINT(-20, 60, -10, 75),
+    STC3115_DERATE_POINT(-10, 75, 0, 85),
+    STC3115_DERATE_POINT(0, 85, 10, 93),
+    STC3115_DERATE_POINT(10, 93, 25, 100),
+    STC3115_DERATE_POINT(25, 100, 45, 100),
+    STC3115_DERATE_POINT(45, 100, 60, 96),
+    STC3115_DERATE_POINT(60, 96, 60, 96)
+};
+
+static const STC3115DeratingPoint liFePO4Table[] STC3115_PROGMEM = {
+    STC3115_DERATE_POINT(-20, 50, -10, 65),
+    STC3115_DERATE_POINT(-10, 65, 0, 80),
+    STC3115_DERATE_POINT(0, 80, 10, 92),
+    STC3115_DERATE_POINT(10, 92, 25, 100),
+    STC3115_DERATE_POINT(25, 100, 45, 100),
+    STC3115_DERATE_POINT(45, 100, 60, 97),
+    STC3115_DERATE_POINT(60, 97, 60, 97)
+};
+
+STC3115Derating::STC3115Derating():
+ chemistry(STC3115_CHEMISTRY_NONE),
+ table(NULL),
+ tableSize(0),
+ lastTemperature(0),
+ lastFactor(STC3115_DERATE_UNITY) {}
+
+/**
+ * @brief Select the derating table. STC3115_CHEMISTRY_NONE disables derating.
+ *
+ * @param chemistry battery chemistry
+ */
+void STC3115Derating::setChemistry(STC3115Chemistry chemistry) {
+    this->chemistry = chemistry;
+
+    switch (chemistry) {
+    case STC3115_CHEMISTRY_LIION:
+        table = liIonTable;
+        tableSize = sizeof(liIonTable) / sizeof(liIonTable[0]);
+        break;
+    case STC3115_CHEMISTRY_LIFEPO4:
+        table = liFePO4Table;
+        tableSize = sizeof(liFePO4Table) / sizeof(liFePO4Table[0]);
+        break;
+    default:
+        table = NULL;
+        tableSize = 0;
+        break;
+    }
+
+    lastFactor = interpolate(table, tableSize, lastTemperature);
+}
+
+/**
+ * @brief Get the selected chemistry
+ *
+ * @return STC3115Chemistry
+ */
+STC3115Chemistry STC3115Derating::getChemistry() {
+    return chemistry;
+}
+
+/**
+ * @brief Get the usable fraction of the nominal capacity
+ *
+ * @param temperature battery temperature in 0.1 degree
+ * @return uint16_t fraction in Q15
+ */
+uint16_t STC3115Derating::getFactor(int temperature) {
+    if (temperature != lastTemperature) {
+        lastTemperature = temperature;
+        lastFactor = interpolate(table, tableSize, temperature);
+    }
+
+    return lastFactor;
+}
+
+/**
+ * @brief Scale a capacity-derived value by the usable fraction at a temperature
+ *
+ * @param value value at nominal capacity, e.g. remaining charge in mAh
+ * @param temperature battery temperature in 0.1 degree
+ * @return int
+ */
+int STC3115Derating::apply(int value, int temperature) {
+    uint16_t factor = getFactor(temperature);
+    if (factor == STC3115_DERATE_UNITY) {
+        return value;
+    }
+
+    return static_cast<int>((static_cast<int32_t>(value) * factor) >> STC3115_DERATE_FRACTION_BITS);
+}
+
+/**
+ * @brief Linear interpolation between the table points, clamped to the first and last point
+ *
+ */
+uint16_t STC3115Derating::interpolate(const STC3115DeratingPoint* table, uint8_t size, int temperature) {
+    if (table == NULL || size == 0) {
+        return STC3115_DERATE_UNITY;
+    }
+
+    STC3115DeratingPoint point;
+    stc3115_read_flash(&point, &table[0], sizeof(point));
+    if (temperature <= point.Temperature) {
+        return point.Factor;
+    }
+
+    for (uint8_t i = 1; i < size; i++) {
+        STC3115DeratingPoint next;
+        stc3115_read_flash(&next, &table[i], sizeof(next));
+        if (temperature < next.Temperature) {
+            break;
+        }
+
+        point = next;
+    }
+
+    int32_t factor = point.Factor + ((point.Slope * (temperature - point.Temperature)) >> STC3115_DERATE_SLOPE_BITS);
+    if (factor > STC3115_DERATE_UNITY) {
+        factor = STC3115_DERATE_UNITY;
+    } else if (factor < 0) {
+        factor = 0;
+    }
+
+    return static_cast<uint16_t>(factor);
+}
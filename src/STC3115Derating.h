@@ -0,0 +1,73 @@
+#ifndef STC3115_DERATING_H
+#define STC3115_DERATING_H
+
+#include <stdint.h>
+#include "STC3115_platform.h"
+
+#define STC3115_DERATE_FRACTION_BITS 15
+#define STC3115_DERATE_SLOPE_BITS 8
+#define STC3115_DERATE_UNITY (1 << STC3115_DERATE_FRACTION_BITS)
+
+/**
+ * @brief Battery chemistry selecting the capacity-vs-temperature table
+ *
+ */
+typedef enum {
+    STC3115_CHEMISTRY_NONE = 0,
+    STC3115_CHEMISTRY_LIION,
+    STC3115_CHEMISTRY_LIFEPO4
+} STC3115Chemistry;
+
+/**
+ * @brief Point of a derating table.
+ *
+ * Temperature is in 0.1 degree, Factor is the usable fraction of the nominal capacity in Q15, and Slope is the
+ * change of Factor per 0.1 degree up to the next point in Q15 shifted left by STC3115_DERATE_SLOPE_BITS.
+ */
+typedef struct {
+    int16_t Temperature;
+    uint16_t Factor;
+    int32_t Slope;
+} STC3115DeratingPoint;
+
+constexpr uint16_t stc3115DerateFactor(int percent) {
+    return static_cast<uint16_t>((static_cast<int32_t>(percent) * STC3115_DERATE_UNITY + 50) / 100);
+}
+
+constexpr int32_t stc3115DerateSlope(int temperature, int percent, int nextTemperature, int nextPercent) {
+    return nextTemperature == temperature ? 0 :
+        ((static_cast<int32_t>(stc3115DerateFactor(nextPercent)) - stc3115DerateFactor(percent)) * (1 << STC3115_DERATE_SLOPE_BITS)) /
+        ((nextTemperature - temperature) * 10);
+}
+
+/**
+ * @brief Define a table point in degrees and percent; the slope to the next point is computed at compile time.
+ *
+ */
+#define STC3115_DERATE_POINT(temperature, percent, nextTemperature, nextPercent) \
+    { (temperature) * 10, stc3115DerateFactor(percent), stc3115DerateSlope(temperature, percent, nextTemperature, nextPercent) }
+
+/**
+ * @brief Usable capacity depending on the battery temperature, interpolated in fixed point from tables in flash.
+ *
+ * The factor is only recomputed when the temperature changes, so a tick usually costs one comparison.
+ */
+class STC3115Derating {
+public:
+    STC3115Derating();
+
+    void setChemistry(STC3115Chemistry chemistry);
+    STC3115Chemistry getChemistry();
+    uint16_t getFactor(int temperature);
+    int apply(int value, int temperature);
+private:
+    static uint16_t interpolate(const STC3115DeratingPoint* table, uint8_t size, int temperature);
+
+    STC3115Chemistry chemistry;
+    const STC3115DeratingPoint* table;
+    uint8_t tableSize;
+    int lastTemperature;
+    uint16_t lastFactor;
+};
+
+#endif
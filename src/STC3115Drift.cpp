@@ -0,0 +1,155 @@
+#include "STC3115Drift.h"
+#include "STC3115_registers.h"
+
+STC3115DriftMonitor::STC3115DriftMonitor():
+ enabled(false),
+ synced(false),
+ window(STC3115_DRIFT_WINDOW),
+ lastCounter(0),
+ ccCleared(0),
+ vmCleared(0),
+ lastCCAccumulated(0),
+ lastVMAccumulated(0) {
+    data.CCAdjust = 0;
+    data.VMAdjust = 0;
+    data.CCAccumulated = 0;
+    data.VMAccumulated = 0;
+    data.CCRate = 0;
+    data.VMRate = 0;
+    data.Samples = 0;
+}
+
+/**
+ * @brief Start sampling the adjustment registers
+ *
+ * @param window number of conversions between two samples
+ */
+void STC3115DriftMonitor::enable(uint16_t window) {
+    this->window = window > 0 ? window : 1;
+    enabled = true;
+    synced = false;
+}
+
+/**
+ * @brief Stop sampling the adjustment registers
+ *
+ */
+void STC3115DriftMonitor::disable() {
+    enabled = false;
+}
+
+/**
+ * @brief Check whether the monitor samples the adjustment registers
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115DriftMonitor::isEnabled() {
+    return enabled;
+}
+
+/**
+ * @brief Sample the adjustment registers if a new adjustment window started since the last sample.
+ *
+ * Costs nothing on the bus until the conversion counter has moved by a full window, then two register reads.
+ *
+ * @param core bus access of the gauge
+ * @param battery latest measurement set of a running gauge
+ * @return true if a new sample was taken
+ * @return false otherwise
+ */
+bool STC3115DriftMonitor::update(STC3115I2CCore& core, const STC3115BatteryData& battery) {
+    if (!enabled) {
+        return false;
+    }
+
+    if (synced) {
+        uint32_t conversions = static_cast<uint32_t>(battery.ConvCounter - lastCounter) & 0xffff;
+        if (conversions < window) {
+            return false;
+        }
+    }
+
+    uint8_t high[2];
+    uint8_t low[6];
+    if (!core.readRegisterRegion(high, STC3115_REG_CC_ADJ_HIGH, 2) || !core.readRegisterRegion(low, STC3115_REG_CC_ADJ_LOW, 6)) {
+        return false;
+    }
+
+    int16_t ccAdjust = static_cast<int16_t>(low[0] | (high[0] << 8));
+    int16_t vmAdjust = static_cast<int16_t>(low[1] | (high[1] << 8));
+    int16_t ccAccumulated = static_cast<int16_t>(low[2] | (low[3] << 8));
+    int16_t vmAccumulated = static_cast<int16_t>(low[4] | (low[5] << 8));
+
+    data.CCAdjust = toHundredths(ccAdjust);
+    data.VMAdjust = toHundredths(vmAdjust);
+    data.CCAccumulated = ccCleared + toHundredths(ccAccumulated);
+    data.VMAccumulated = vmCleared + toHundredths(vmAccumulated);
+
+    if (synced) {
+        uint32_t conversions = static_cast<uint32_t>(battery.ConvCounter - lastCounter) & 0xffff;
+        uint32_t period = (battery.StatusWord & STC3115_VMODE) != 0 ? STC3115_CONV_PERIOD_VM_MS : STC3115_CONV_PERIOD_MIXED_MS;
+        int64_t elapsed = static_cast<int64_t>(conversions) * period;
+        bool first = data.Samples == 0;
+
+        data.CCRate = smooth(data.CCRate, (data.CCAccumulated - lastCCAccumulated) * 3600000LL / elapsed, first);
+        data.VMRate = smooth(data.VMRate, (data.VMAccumulated - lastVMAccumulated) * 3600000LL / elapsed, first);
+        data.Samples++;
+    }
+
+    lastCounter = battery.ConvCounter;
+    lastCCAccumulated = data.CCAccumulated;
+    lastVMAccumulated = data.VMAccumulated;
+    synced = true;
+
+    if (ccAccumulated > STC3115_DRIFT_CLEAR_THRESHOLD || ccAccumulated < -STC3115_DRIFT_CLEAR_THRESHOLD ||
+        vmAccumulated > STC3115_DRIFT_CLEAR_THRESHOLD || vmAccumulated < -STC3115_DRIFT_CLEAR_THRESHOLD) {
+        uint8_t mode = 0;
+        if (core.readRegister(&mode, STC3115_REG_MODE) &&
+            core.writeRegister(STC3115_REG_MODE, mode | STC3115_CLR_CC_ADJ | STC3115_CLR_VM_ADJ)) {
+            ccCleared += toHundredths(ccAccumulated);
+            vmCleared += toHundredths(vmAccumulated);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Restart the sampling window after the gauge was restarted and its accumulators reset.
+ *
+ */
+void STC3115DriftMonitor::resync() {
+    synced = false;
+    ccCleared = data.CCAccumulated;
+    vmCleared = data.VMAccumulated;
+}
+
+/**
+ * @brief Get the latest decoded adjustments and drift rates
+ *
+ * @return const STC3115DriftData&
+ */
+const STC3115DriftData& STC3115DriftMonitor::getData() {
+    return data;
+}
+
+/**
+ * @brief Convert an adjustment register value (1/512 %) to 0.01%
+ *
+ */
+int32_t STC3115DriftMonitor::toHundredths(int16_t value) {
+    return static_cast<int32_t>(value) * 100 / 512;
+}
+
+/**
+ * @brief Exponential moving average with a weight of 1/2^STC3115_DRIFT_SMOOTHING for the new value
+ *
+ */
+int32_t STC3115DriftMonitor::smooth(int32_t average, int32_t value, bool first) {
+    if (first) {
+        return value;
+    }
+
+    return average + (value - average) / (1 << STC3115_DRIFT_SMOOTHING);
+}
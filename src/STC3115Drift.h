@@ -0,0 +1,47 @@
+#ifndef STC3115_DRIFT_H
+#define STC3115_DRIFT_H
+
+#include <stdint.h>
+#include "STC3115_types.h"
+#include "STC3115I2CCore.h"
+
+#ifndef STC3115_DRIFT_WINDOW
+#define STC3115_DRIFT_WINDOW 120
+#endif
+
+#define STC3115_DRIFT_CLEAR_THRESHOLD 0x4000
+#define STC3115_DRIFT_SMOOTHING 3
+
+/**
+ * @brief Samples the CC/VM adjustment registers once per adjustment window and tracks how fast they drift.
+ *
+ * The voltage mode keeps correcting the coulomb counter. A steadily growing correction in the same direction
+ * points at a miscalibrated sense resistor or a wrong capacity. The accumulators are cleared through the MODE
+ * register before they saturate; the cleared amount is kept in the totals.
+ */
+class STC3115DriftMonitor {
+public:
+    STC3115DriftMonitor();
+
+    void enable(uint16_t window = STC3115_DRIFT_WINDOW);
+    void disable();
+    bool isEnabled();
+    bool update(STC3115I2CCore& core, const STC3115BatteryData& data);
+    void resync();
+    const STC3115DriftData& getData();
+private:
+    static int32_t toHundredths(int16_t value);
+    static int32_t smooth(int32_t average, int32_t value, bool first);
+
+    STC3115DriftData data;
+    bool enabled;
+    bool synced;
+    uint16_t window;
+    int lastCounter;
+    int32_t ccCleared;
+    int32_t vmCleared;
+    int32_t lastCCAccumulated;
+    int32_t lastVMAccumulated;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "STC3115Energy.h"
+
+#define STC3115_MAMS_PER_MAH 3600000ULL
+#define STC3115_UWMS_PER_MWH 3600000000ULL
+
+STC3115EnergyCounter::STC3115EnergyCounter():
+ synced(false),
+ lastCounter(0),
+ lastCurrent(0),
+ lastVoltage(0) {
+    clear();
+}
+
+/**
+ * @brief Integrate the interval between the previous measurement set and this one
+ *
+ * @param data measurement set of a running gauge
+ */
+void STC3115EnergyCounter::update(const STC3115BatteryData& data) {
+    if (!synced) {
+        synced = true;
+        lastCounter = data.ConvCounter;
+        lastCurrent = data.Current;
+        lastVoltage = data.Voltage;
+        return;
+    }
+
+    uint32_t conversions = static_cast<uint32_t>(data.ConvCounter - lastCounter) & 0xffff;
+    if (conversions == 0) {
+        return;
+    }
+
+    uint32_t period = (data.StatusWord & STC3115_VMODE) != 0 ? STC3115_CONV_PERIOD_VM_MS : STC3115_CONV_PERIOD_MIXED_MS;
+    uint64_t elapsed = static_cast<uint64_t>(conversions) * period;
+    int current = (lastCurrent + data.Current) / 2;
+    int voltage = (lastVoltage + data.Voltage) / 2;
+
+    if (current > STC3115_IDLE_CURRENT) {
+        uint64_t charge = static_cast<uint64_t>(current) * elapsed;
+        state.ChargeIn += charge;
+        state.EnergyIn += charge * voltage;
+        state.TimeCharging += elapsed;
+    } else if (current < -STC3115_IDLE_CURRENT) {
+        uint64_t charge = static_cast<uint64_t>(-current) * elapsed;
+        state.ChargeOut += charge;
+        state.EnergyOut += charge * voltage;
+        state.TimeDischarging += elapsed;
+    } else {
+        state.TimeIdle += elapsed;
+    }
+
+    lastCounter = data.ConvCounter;
+    lastCurrent = data.Current;
+    lastVoltage = data.Voltage;
+}
+
+/**
+ * @brief Restart the time base, e.g. after the gauge was restarted and its conversion counter reset.
+ *
+ */
+void STC3115EnergyCounter::resync() {
+    synced = false;
+}
+
+/**
+ * @brief Clear every accumulator
+ *
+ */
+void STC3115EnergyCounter::clear() {
+    state.ChargeIn = 0;
+    state.ChargeOut = 0;
+    state.EnergyIn = 0;
+    state.EnergyOut = 0;
+    state.TimeCharging = 0;
+    state.TimeDischarging = 0;
+    state.TimeIdle = 0;
+    synced = false;
+}
+
+/**
+ * @brief Copy the accumulators for persistence
+ *
+ * @param state pointer to the structure that will hold the accumulators
+ */
+void STC3115EnergyCounter::exportState(STC3115EnergyState* state) {
+    *state = this->state;
+}
+
+/**
+ * @brief Restore previously exported accumulators
+ *
+ * @param state accumulators
+ */
+void STC3115EnergyCounter::importState(const STC3115EnergyState& state) {
+    this->state = state;
+    synced = false;
+}
+
+/**
+ * @brief Get the charge that went into the battery
+ *
+ * @return uint32_t charge in mAh
+ */
+uint32_t STC3115EnergyCounter::getChargeIn() {
+    return state.ChargeIn / STC3115_MAMS_PER_MAH;
+}
+
+/**
+ * @brief Get the charge that was drawn from the battery
+ *
+ * @return uint32_t charge in mAh
+ */
+uint32_t STC3115EnergyCounter::getChargeOut() {
+    return state.ChargeOut / STC3115_MAMS_PER_MAH;
+}
+
+/**
+ * @brief Get the energy that went into the battery
+ *
+ * @return uint32_t energy in mWh
+ */
+uint32_t STC3115EnergyCounter::getEnergyIn() {
+    return state.EnergyIn / STC3115_UWMS_PER_MWH;
+}
+
+/**
+ * @brief Get the energy that was drawn from the battery
+ *
+ * @return uint32_t energy in mWh
+ */
+uint32_t STC3115EnergyCounter::getEnergyOut() {
+    return state.EnergyOut / STC3115_UWMS_PER_MWH;
+}
+
+/**
+ * @brief Get the number of equivalent full cycles, i.e. discharged charge divided by capacity
+ *
+ * @param capacity battery capacity in mAh
+ * @return uint32_t cycles in 0.01 cycle unit
+ */
+uint32_t STC3115EnergyCounter::getCycles(int capacity) {
+    if (capacity <= 0) {
+        return 0;
+    }
+
+    return state.ChargeOut * 100 / (STC3115_MAMS_PER_MAH * capacity);
+}
+
+/**
+ * @brief Get the time spent charging
+ *
+ * @return uint32_t time in seconds
+ */
+uint32_t STC3115EnergyCounter::getTimeCharging() {
+    return state.TimeCharging / 1000;
+}
+
+/**
+ * @brief Get the time spent discharging
+ *
+ * @return uint32_t time in seconds
+ */
+uint32_t STC3115EnergyCounter::getTimeDischarging() {
+    return state.TimeDischarging / 1000;
+}
+
+/**
+ * @brief Get the time spent with a current below STC3115_IDLE_CURRENT
+ *
+ * @return uint32_t time in seconds
+ */
+uint32_t STC3115EnergyCounter::getTimeIdle() {
+    return state.TimeIdle / 1000;
+}
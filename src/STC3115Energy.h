@@ -0,0 +1,40 @@
+#ifndef STC3115_ENERGY_H
+#define STC3115_ENERGY_H
+
+#include <stdint.h>
+#include "STC3115_types.h"
+
+/**
+ * @brief Integrates charge, energy and time spent charging or discharging from consecutive measurement sets.
+ *
+ * The gauge conversion counter is the time base, so several conversions between two polls are integrated
+ * with the trapezoidal rule instead of being lost. Accumulators are 64-bit and do not overflow in the life of a battery.
+ */
+class STC3115EnergyCounter {
+public:
+    STC3115EnergyCounter();
+
+    void update(const STC3115BatteryData& data);
+    void resync();
+    void clear();
+
+    void exportState(STC3115EnergyState* state);
+    void importState(const STC3115EnergyState& state);
+
+    uint32_t getChargeIn();
+    uint32_t getChargeOut();
+    uint32_t getEnergyIn();
+    uint32_t getEnergyOut();
+    uint32_t getCycles(int capacity);
+    uint32_t getTimeCharging();
+    uint32_t getTimeDischarging();
+    uint32_t getTimeIdle();
+private:
+    STC3115EnergyState state;
+    bool synced;
+    int lastCounter;
+    int lastCurrent;
+    int lastVoltage;
+};
+
+#endif
@@ -0,0 +1,224 @@
+#include "STC3115Events.h"
+
+STC3115EventRegistry::STC3115EventRegistry():
+ socSubscriptions(0),
+ primed(false),
+ socKnown(false),
+ lastSOC(0),
+ lastPresence(0),
+ lastState(0),
+ lastDirection(0),
+ lastFlags(0) {
+    clear();
+}
+
+/**
+ * @brief Register a callback for a kind of change.
+ *
+ * @param type kind of change
+ * @param callback function called on change, from the task that calls run()
+ * @param context pointer passed back to the callback
+ * @param threshold SOC threshold in 0.1% (STC3115_EVENT_SOC_CROSSING only)
+ * @param hysteresis SOC hysteresis in 0.1% above the threshold (STC3115_EVENT_SOC_CROSSING only)
+ * @return int subscription ID, or -1 if the registry is full
+ */
+int STC3115EventRegistry::subscribe(STC3115EventType type, STC3115EventCallback callback, void* context, int threshold, int hysteresis) {
+    if (callback == NULL || type >= STC3115_EVENT_TYPE_COUNT) {
+        return -1;
+    }
+
+    for (int i = 0; i < STC3115_MAX_SUBSCRIPTIONS; i++) {
+        Subscription* subscription = &subscriptions[i];
+        if (subscription->Callback != NULL) {
+            continue;
+        }
+
+        subscription->Callback = callback;
+        subscription->Context = context;
+        subscription->Threshold = threshold;
+        subscription->Hysteresis = hysteresis < 0 ? 0 : hysteresis;
+        subscription->Level = socKnown ? socLevel(*subscription, lastSOC, 0) : -1;
+        subscription->Type = type;
+
+        if (type == STC3115_EVENT_SOC_CROSSING) {
+            socSubscriptions++;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Remove a subscription
+ *
+ * @param id subscription ID returned by subscribe()
+ * @return true
+ * @return false if there is no such subscription
+ */
+bool STC3115EventRegistry::unsubscribe(int id) {
+    if (id < 0 || id >= STC3115_MAX_SUBSCRIPTIONS || subscriptions[id].Callback == NULL) {
+        return false;
+    }
+
+    if (subscriptions[id].Type == STC3115_EVENT_SOC_CROSSING) {
+        socSubscriptions--;
+    }
+
+    subscriptions[id].Callback = NULL;
+    return true;
+}
+
+/**
+ * @brief Remove every subscription
+ *
+ */
+void STC3115EventRegistry::clear() {
+    for (int i = 0; i < STC3115_MAX_SUBSCRIPTIONS; i++) {
+        subscriptions[i].Callback = NULL;
+    }
+
+    socSubscriptions = 0;
+}
+
+/**
+ * @brief Compare a new measurement set with the previous one and notify the subscribers of what changed.
+ *
+ * The first call only records a baseline. Ticks where nothing changed return after a handful of comparisons.
+ *
+ * @param data new measurement set
+ * @param state gauge state from the RAM (STC3115_INIT, STC3115_RUNNING...)
+ */
+void STC3115EventRegistry::evaluate(const STC3115BatteryData& data, int state) {
+    int currentDirection = direction(data.Current);
+    int flags = (data.StatusWord >> 8) & (STC3115_PORDET | STC3115_BATFAIL);
+
+    bool converged = data.Provisional == 0;
+    if (!primed) {
+        primed = true;
+        socKnown = converged;
+        lastSOC = data.SOC;
+        lastPresence = data.Presence;
+        lastState = state;
+        lastDirection = currentDirection;
+        lastFlags = flags;
+
+        for (int i = 0; i < STC3115_MAX_SUBSCRIPTIONS; i++) {
+            subscriptions[i].Level = converged ? socLevel(subscriptions[i], data.SOC, 0) : -1;
+        }
+
+        return;
+    }
+
+    bool socChanged = converged && (data.SOC != lastSOC || !socKnown) && socSubscriptions > 0;
+    if (!socChanged && data.Presence == lastPresence && state == lastState && currentDirection == lastDirection && flags == lastFlags) {
+        if (converged) {
+            lastSOC = data.SOC;
+            socKnown = true;
+        }
+
+        return;
+    }
+
+    if (socChanged) {
+        for (int i = 0; i < STC3115_MAX_SUBSCRIPTIONS; i++) {
+            Subscription* subscription = &subscriptions[i];
+            if (subscription->Callback == NULL || subscription->Type != STC3115_EVENT_SOC_CROSSING) {
+                continue;
+            }
+
+            int8_t level = socLevel(*subscription, data.SOC, subscription->Level);
+            if (subscription->Level >= 0 && level != subscription->Level) {
+                STC3115Event event = {STC3115_EVENT_SOC_CROSSING, level, subscription->Level, data.SOC};
+                subscription->Level = level;
+                subscription->Callback(event, subscription->Context);
+            } else {
+                subscription->Level = level;
+            }
+        }
+    }
+
+    if (data.Presence != lastPresence) {
+        notify(STC3115_EVENT_PRESENCE, data.Presence, lastPresence, data.SOC);
+    }
+
+    if (state != lastState) {
+        notify(STC3115_EVENT_STATE, state, lastState, data.SOC);
+    }
+
+    if (currentDirection != lastDirection) {
+        notify(STC3115_EVENT_DIRECTION, currentDirection, lastDirection, data.SOC);
+    }
+
+    int raised = flags & ~lastFlags;
+    if ((raised & STC3115_PORDET) != 0) {
+        notify(STC3115_EVENT_PORDET, 1, 0, data.SOC);
+    }
+
+    if ((raised & STC3115_BATFAIL) != 0) {
+        notify(STC3115_EVENT_BATFAIL, 1, 0, data.SOC);
+    }
+
+    if (converged) {
+        lastSOC = data.SOC;
+        socKnown = true;
+    }
+
+    lastPresence = data.Presence;
+    lastState = state;
+    lastDirection = currentDirection;
+    lastFlags = flags;
+}
+
+/**
+ * @brief Call every subscriber of a kind of change
+ *
+ */
+void STC3115EventRegistry::notify(uint8_t type, int value, int previous, int soc) {
+    STC3115Event event = {static_cast<STC3115EventType>(type), value, previous, soc};
+
+    for (int i = 0; i < STC3115_MAX_SUBSCRIPTIONS; i++) {
+        if (subscriptions[i].Callback != NULL && subscriptions[i].Type == type) {
+            subscriptions[i].Callback(event, subscriptions[i].Context);
+        }
+    }
+}
+
+/**
+ * @brief Get the side of a SOC threshold, keeping the previous side inside the hysteresis band
+ *
+ * @param subscription SOC crossing subscription
+ * @param soc state of charge in 0.1%
+ * @param level previous side: 0 below, 1 above
+ * @return int8_t
+ */
+int8_t STC3115EventRegistry::socLevel(const Subscription& subscription, int soc, int8_t level) {
+    if (soc < subscription.Threshold) {
+        return 0;
+    }
+
+    if (soc >= subscription.Threshold + subscription.Hysteresis) {
+        return 1;
+    }
+
+    return level < 0 ? 0 : level;
+}
+
+/**
+ * @brief Classify a current as charging, discharging or idle
+ *
+ * @param current battery current in mA
+ * @return int 1, -1 or 0
+ */
+int STC3115EventRegistry::direction(int current) {
+    if (current > STC3115_DIRECTION_DEADBAND) {
+        return 1;
+    }
+
+    if (current < -STC3115_DIRECTION_DEADBAND) {
+        return -1;
+    }
+
+    return 0;
+}
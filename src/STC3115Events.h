@@ -0,0 +1,87 @@
+#ifndef STC3115_EVENTS_H
+#define STC3115_EVENTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "STC3115_types.h"
+
+#ifndef STC3115_MAX_SUBSCRIPTIONS
+#define STC3115_MAX_SUBSCRIPTIONS 8
+#endif
+
+#ifndef STC3115_DIRECTION_DEADBAND
+#define STC3115_DIRECTION_DEADBAND 10
+#endif
+
+/**
+ * @brief Kind of change a subscription listens to
+ *
+ */
+typedef enum {
+    STC3115_EVENT_SOC_CROSSING = 0,
+    STC3115_EVENT_PRESENCE,
+    STC3115_EVENT_STATE,
+    STC3115_EVENT_DIRECTION,
+    STC3115_EVENT_PORDET,
+    STC3115_EVENT_BATFAIL,
+    STC3115_EVENT_TYPE_COUNT
+} STC3115EventType;
+
+/**
+ * @brief Change reported to a subscriber.
+ *
+ * For STC3115_EVENT_SOC_CROSSING value is 1 when SOC rose to threshold + hysteresis and 0 when it fell below threshold.
+ * For STC3115_EVENT_PRESENCE value is the new presence, for STC3115_EVENT_STATE the new gauge state
+ * (STC3115_INIT, STC3115_RUNNING...), for STC3115_EVENT_DIRECTION 1 when charging, -1 when discharging and 0 when idle.
+ * PORDET and BATFAIL events are reported when the flag is first observed, with value 1.
+ */
+typedef struct {
+    STC3115EventType Type;
+    int Value;
+    int Previous;
+    int SOC;
+} STC3115Event;
+
+typedef void (*STC3115EventCallback)(const STC3115Event& event, void* context);
+
+/**
+ * @brief Fixed-size, allocation-free registry of change subscriptions evaluated once per measurement set.
+ *
+ * SOC crossings only follow measurement sets of a converged gauge; provisional estimates (Provisional set to 1)
+ * neither raise them nor become the reference SOC. The other changes are evaluated on every set, and the SOC
+ * reported with them may be provisional.
+ */
+class STC3115EventRegistry {
+public:
+    STC3115EventRegistry();
+
+    int subscribe(STC3115EventType type, STC3115EventCallback callback, void* context = NULL, int threshold = 0, int hysteresis = 0);
+    bool unsubscribe(int id);
+    void clear();
+    void evaluate(const STC3115BatteryData& data, int state);
+private:
+    struct Subscription {
+        STC3115EventCallback Callback;
+        void* Context;
+        int16_t Threshold;
+        int16_t Hysteresis;
+        int8_t Level;
+        uint8_t Type;
+    };
+
+    void notify(uint8_t type, int value, int previous, int soc);
+    static int8_t socLevel(const Subscription& subscription, int soc, int8_t level);
+    static int direction(int current);
+
+    Subscription subscriptions[STC3115_MAX_SUBSCRIPTIONS];
+    uint8_t socSubscriptions;
+    bool primed;
+    bool socKnown;
+    int lastSOC;
+    int lastPresence;
+    int lastState;
+    int lastDirection;
+    int lastFlags;
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include "STC3115Health.h"
+#include "STC3115_constants.h"
+#include "STC3115_registers.h"
+
+STC3115HealthEstimator::STC3115HealthEstimator():
+ nominal(0),
+ capacity(0),
+ measurements(0),
+ rejected(0),
+ anchor(ANCHOR_NONE),
+ synced(false),
+ anchorHRSOC(0),
+ lastCounter(0),
+ charge(0) {
+}
+
+/**
+ * @brief Set the nominal capacity programmed at begin(). An estimate made for another nominal capacity, i.e. for
+ * another battery, is dropped.
+ *
+ * @param capacity nominal capacity in mAh
+ */
+void STC3115HealthEstimator::setNominalCapacity(int capacity) {
+    if (capacity != nominal) {
+        this->capacity = 0;
+        measurements = 0;
+        rejected = 0;
+    }
+
+    nominal = capacity;
+}
+
+/**
+ * @brief Add the charge of a new conversion to the open segment and take a measurement when it reaches an anchor.
+ *
+ * Measurement sets of the same conversion are ignored.
+ *
+ * @param data latest measurement set of a running gauge
+ * @return true if a measurement was accepted
+ * @return false otherwise
+ */
+bool STC3115HealthEstimator::update(const STC3115BatteryData& data) {
+    if (synced && data.ConvCounter == lastCounter) {
+        return false;
+    }
+
+    if (!synced || (data.StatusWord & STC3115_VMODE) != 0) {
+        anchor = ANCHOR_NONE;
+    } else {
+        charge += static_cast<int32_t>(data.Current) * ((data.ConvCounter - lastCounter) & 0xffff);
+    }
+
+    lastCounter = data.ConvCounter;
+    synced = true;
+    if ((data.StatusWord & STC3115_VMODE) != 0) {
+        return false;
+    }
+
+    bool accepted = false;
+    if (data.SOC >= STC3115_HEALTH_HIGH_SOC) {
+        if (anchor == ANCHOR_LOW) {
+            accepted = measure(data.HRSOC);
+        }
+
+        setAnchor(ANCHOR_HIGH, data.HRSOC);
+    } else if (data.SOC <= STC3115_HEALTH_LOW_SOC) {
+        if (anchor == ANCHOR_HIGH) {
+            accepted = measure(data.HRSOC);
+        }
+
+        setAnchor(ANCHOR_LOW, data.HRSOC);
+    }
+
+    return accepted;
+}
+
+/**
+ * @brief Drop the open segment after the gauge was restarted. The estimate is kept.
+ *
+ */
+void STC3115HealthEstimator::resync() {
+    synced = false;
+    anchor = ANCHOR_NONE;
+}
+
+/**
+ * @brief Forget the estimate and the open segment
+ *
+ */
+void STC3115HealthEstimator::clear() {
+    capacity = 0;
+    measurements = 0;
+    rejected = 0;
+    resync();
+}
+
+/**
+ * @brief Copy the estimate to a persistent structure
+ *
+ * @param state structure that will hold the estimate
+ */
+void STC3115HealthEstimator::exportState(STC3115HealthState* state) {
+    state->Nominal = nominal;
+    state->Capacity = capacity;
+    state->Measurements = measurements;
+    state->Rejected = rejected;
+}
+
+/**
+ * @brief Restore an estimate saved by exportState(). It is dropped again if it was made for another nominal
+ * capacity than the one passed to begin().
+ *
+ * @param state saved estimate
+ */
+void STC3115HealthEstimator::importState(const STC3115HealthState& state) {
+    if (nominal != 0 && state.Nominal != nominal) {
+        return;
+    }
+
+    nominal = state.Nominal;
+    capacity = state.Capacity;
+    measurements = state.Measurements;
+    rejected = state.Rejected;
+}
+
+/**
+ * @brief Get the usable capacity: the estimate once a measurement was accepted, the nominal capacity before.
+ *
+ * @return int capacity in mAh
+ */
+int STC3115HealthEstimator::getCapacity() {
+    return measurements != 0 ? capacity : nominal;
+}
+
+/**
+ * @brief Get the state of health, the usable capacity relative to the nominal capacity
+ *
+ * @return int state of health in percent, 100 until a measurement was accepted
+ */
+int STC3115HealthEstimator::getHealth() {
+    if (measurements == 0 || nominal == 0) {
+        return 100;
+    }
+
+    return (static_cast<long>(capacity) * 100 + nominal / 2) / nominal;
+}
+
+/**
+ * @brief Get the number of accepted measurements
+ *
+ * @return uint16_t
+ */
+uint16_t STC3115HealthEstimator::getMeasurementCount() {
+    return measurements;
+}
+
+/**
+ * @brief Get the number of rejected measurements
+ *
+ * @return uint16_t
+ */
+uint16_t STC3115HealthEstimator::getRejectCount() {
+    return rejected;
+}
+
+/**
+ * @brief Close the open segment at the opposite anchor and fold its capacity into the estimate.
+ *
+ * @param hrsoc HRSOC at the opposite anchor
+ * @return true if the measurement was accepted
+ * @return false if it was rejected
+ */
+bool STC3115HealthEstimator::measure(uint16_t hrsoc) {
+    uint16_t span = hrsoc > anchorHRSOC ? hrsoc - anchorHRSOC : anchorHRSOC - hrsoc;
+    if (nominal == 0 || span < static_cast<uint32_t>(MAX_HRSOC) * STC3115_HEALTH_MIN_SPAN / 100) {
+        rejected++;
+        return false;
+    }
+
+    uint64_t counted = charge < 0 ? -static_cast<int64_t>(charge) : charge;
+    uint32_t measured = counted * STC3115_CONV_PERIOD_MIXED_MS * MAX_HRSOC / (static_cast<uint64_t>(3600000) * span);
+    if (measured < static_cast<uint32_t>(nominal) * STC3115_HEALTH_MIN_CAPACITY / 100 ||
+        measured > static_cast<uint32_t>(nominal) * STC3115_HEALTH_MAX_CAPACITY / 100) {
+        rejected++;
+        return false;
+    }
+
+    if (measurements == 0) {
+        capacity = measured;
+    } else {
+        capacity = capacity + (static_cast<int32_t>(measured) - capacity) / (1 << STC3115_HEALTH_SMOOTHING);
+    }
+
+    if (measurements < 0xffff) {
+        measurements++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Restart the segment at an anchor
+ *
+ * @param anchor anchor reached
+ * @param hrsoc HRSOC at the anchor
+ */
+void STC3115HealthEstimator::setAnchor(Anchor anchor, uint16_t hrsoc) {
+    this->anchor = anchor;
+    anchorHRSOC = hrsoc;
+    charge = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef STC3115_HEALTH_H
+#define STC3115_HEALTH_H
+
+#include <stdint.h>
+#include "STC3115_types.h"
+
+#ifndef STC3115_HEALTH_HIGH_SOC
+#define STC3115_HEALTH_HIGH_SOC 990
+#endif
+
+#ifndef STC3115_HEALTH_LOW_SOC
+#define STC3115_HEALTH_LOW_SOC 100
+#endif
+
+#ifndef STC3115_HEALTH_MIN_SPAN
+#define STC3115_HEALTH_MIN_SPAN 50
+#endif
+
+#ifndef STC3115_HEALTH_MIN_CAPACITY
+#define STC3115_HEALTH_MIN_CAPACITY 40
+#endif
+
+#ifndef STC3115_HEALTH_MAX_CAPACITY
+#define STC3115_HEALTH_MAX_CAPACITY 120
+#endif
+
+#define STC3115_HEALTH_SMOOTHING 2
+
+/**
+ * @brief Estimates the usable capacity of the battery from the charge counted between two SOC anchors.
+ *
+ * The SOC reaching STC3115_HEALTH_HIGH_SOC (a full charge) or falling to STC3115_HEALTH_LOW_SOC (a deep discharge)
+ * sets an anchor; while the SOC stays there the anchor keeps moving with it. From the last anchor on, the current
+ * of each conversion is summed. Once the SOC reaches the opposite anchor, the summed charge divided by the HRSOC
+ * difference is one capacity measurement. Measurements spanning less than STC3115_HEALTH_MIN_SPAN percent or
+ * outside STC3115_HEALTH_MIN_CAPACITY..STC3115_HEALTH_MAX_CAPACITY percent of the nominal capacity are rejected;
+ * accepted ones are smoothed into the estimate.
+ *
+ * A conversion costs an addition and a multiplication; the division happens once per measurement. Voltage mode
+ * reports no current and a gauge restart loses the SOC history, so both drop the open segment.
+ */
+class STC3115HealthEstimator {
+public:
+    STC3115HealthEstimator();
+
+    void setNominalCapacity(int capacity);
+    bool update(const STC3115BatteryData& data);
+    void resync();
+    void clear();
+
+    void exportState(STC3115HealthState* state);
+    void importState(const STC3115HealthState& state);
+
+    int getCapacity();
+    int getHealth();
+    uint16_t getMeasurementCount();
+    uint16_t getRejectCount();
+private:
+    typedef enum {
+        ANCHOR_NONE = 0,
+        ANCHOR_HIGH,
+        ANCHOR_LOW
+    } Anchor;
+
+    bool measure(uint16_t hrsoc);
+    void setAnchor(Anchor anchor, uint16_t hrsoc);
+
+    uint16_t nominal;
+    uint16_t capacity;
+    uint16_t measurements;
+    uint16_t rejected;
+    Anchor anchor;
+    bool synced;
+    uint16_t anchorHRSOC;
+    int lastCounter;
+    int32_t charge;
+};
+
+#endif
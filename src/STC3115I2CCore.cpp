@@ -1,4 +1,6 @@
 #include "STC3115I2CCore.h"
+#include "STC3115_constants.h"
+#include "STC3115_registers.h"
 
 /**
  * @brief Initialize STC3115 I2C driver and assign the address
@@ -6,27 +8,23 @@
  * @param address
  */
 STC3115I2CCore::STC3115I2CCore(uint8_t address):
-address(address) {
+address(address),
+transactionCount(0)
+#if !defined(ARDUINO)
+, bus(NULL)
+#endif
+{
+#if STC3115_ENABLE_REGISTER_CACHE
+    cacheEnabled = false;
+    for (size_t i = 0; i < STC3115_REGISTER_MAP_SIZE / 32; i++) {
+        shadowValid[i] = 0;
+    }
+#endif
 }
 
 STC3115I2CCore::~STC3115I2CCore() {
 }
 
-/**
- * @brief Initialize I2C and check whether the address is available or not
- *
- * @return true
- * @return false
- */
-bool STC3115I2CCore::beginI2C() {
-    bool result = true;
-    Wire.beginTransmission(address);
-
-    result = Wire.endTransmission() == 0;
-
-    return result;
-}
-
 /**
  * @brief Read an unsigned byte from a register and return the read status.
  *
@@ -36,24 +34,7 @@ bool STC3115I2CCore::beginI2C() {
  * @return false
  */
 bool STC3115I2CCore::readRegister(uint8_t* output, uint8_t reg) {
-    uint8_t result = 0;
-    uint8_t numBytes = 1;
-    bool returnValue = true;
-
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-
-    if (Wire.endTransmission() != 0) {
-        returnValue = false;
-    }
-
-    Wire.requestFrom(address, numBytes);
-    while (Wire.available()) {
-        result = Wire.read();
-    }
-
-    *output = result;
-    return returnValue;
+    return readRegisterRegion(output, reg, 1);
 }
 
 /**
@@ -66,30 +47,14 @@ bool STC3115I2CCore::readRegister(uint8_t* output, uint8_t reg) {
  * @return false
  */
 bool STC3115I2CCore::readRegisterRegion(uint8_t* output, uint8_t reg, uint8_t length) {
-    bool returnValue = true;
-    uint8_t counter = 0;
-    uint8_t temp = 0;
-
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    if (Wire.endTransmission() != 0) {
-        returnValue = false;
-    } else {
-        int readLength = 0;
-        int readTimeout = 300;
-        unsigned long start = millis();
-        do {
-            readLength = Wire.requestFrom(address, length);
-            if (readLength == length) {
-                for (int i = 0; i < readLength; i++) {
-                    temp = Wire.read();
-                    *output = temp;
-                    output++;
-                }
-
-                break;
-            }
-        } while (millis() - start >= readTimeout);
+    if (readFromCache(output, reg, length)) {
+        return true;
+    }
+
+    transactionCount++;
+    bool returnValue = busRead(reg, output, length);
+    if (returnValue) {
+        updateCache(reg, output, length);
     }
 
     return returnValue;
@@ -120,16 +85,7 @@ bool STC3115I2CCore::readRegisterInt16(int16_t* output, uint8_t reg) {
  * @return false
  */
 bool STC3115I2CCore::writeRegister(uint8_t reg, uint8_t data) {
-    bool returnValue = true;
-
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    Wire.write(data);
-    if (Wire.endTransmission() != 0) {
-        returnValue = false;
-    }
-
-    return returnValue;
+    return writeRegister(reg, &data, 1);
 }
 
 /**
@@ -141,19 +97,11 @@ bool STC3115I2CCore::writeRegister(uint8_t reg, uint8_t data) {
  * @return false
  */
 bool STC3115I2CCore::writeRegisterInt(uint8_t reg, int data) {
-    bool returnValue = true;
-    uint8_t msb = (data >> 8) & 0xFF;
-    uint8_t lsb = data & 0xFF;
-
-    Wire.beginTransmission(address);
-    Wire.write(reg);
-    Wire.write(lsb);
-    Wire.write(msb);
-    if (Wire.endTransmission() != 0) {
-        returnValue = false;
-    }
+    uint8_t buffer[2];
+    buffer[0] = data & 0xFF;
+    buffer[1] = (data >> 8) & 0xFF;
 
-    return returnValue;
+    return writeRegister(reg, buffer, 2);
 }
 
 /**
@@ -182,17 +130,174 @@ bool STC3115I2CCore::readRegisterInt(int* output, uint8_t reg) {
  * @return false
  */
 bool STC3115I2CCore::writeRegister(uint8_t reg, uint8_t* data, size_t length) {
-    bool returnValue = true;
-    Wire.beginTransmission(address);
-    Wire.write(reg);
+    transactionCount++;
+    bool returnValue = busWrite(reg, data, length);
+
+    if (reg == STC3115_REG_CTRL && length > 0 && (data[0] & STC3115_PORDET) != 0) {
+        invalidateRegisterCache();
+    } else if (returnValue) {
+        updateCache(reg, data, length);
+    }
+
+    return returnValue;
+}
+
+/**
+ * @brief Serve subsequent reads of static registers from the register shadow instead of the bus.
+ *
+ */
+void STC3115I2CCore::enableRegisterCache() {
+#if STC3115_ENABLE_REGISTER_CACHE
+    invalidateRegisterCache();
+    cacheEnabled = true;
+#endif
+}
+
+/**
+ * @brief Send every register read to the bus again.
+ *
+ */
+void STC3115I2CCore::disableRegisterCache() {
+#if STC3115_ENABLE_REGISTER_CACHE
+    cacheEnabled = false;
+    invalidateRegisterCache();
+#endif
+}
+
+/**
+ * @brief Drop every write-through entry of the register shadow. Cache-forever entries are kept.
+ *
+ * Called when the gauge reports PORDET or BATFAIL, or when the driver requests a soft reset.
+ */
+void STC3115I2CCore::invalidateRegisterCache() {
+#if STC3115_ENABLE_REGISTER_CACHE
+    for (size_t i = 0; i < STC3115_REGISTER_MAP_SIZE / 32; i++) {
+        uint32_t keep = 0;
+        for (uint8_t bit = 0; bit < 32; bit++) {
+            uint8_t reg = i * 32 + bit;
+            if (getRegisterPolicy(reg) == STC3115_POLICY_CACHE_FOREVER) {
+                keep |= static_cast<uint32_t>(1) << bit;
+            }
+        }
+
+        shadowValid[i] &= keep;
+    }
+#endif
+}
+
+/**
+ * @brief Check whether the register shadow is in use. Always false when STC3115_ENABLE_REGISTER_CACHE is 0.
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::isRegisterCacheEnabled() {
+#if STC3115_ENABLE_REGISTER_CACHE
+    return cacheEnabled;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Get the number of bus transactions issued so far. Wraps around; only differences are meaningful.
+ *
+ * @return uint16_t
+ */
+uint16_t STC3115I2CCore::getTransactionCount() {
+    return transactionCount;
+}
+
+/**
+ * @brief Get the caching policy of a register.
+ *
+ * Registers updated by the gauge itself (status, measurements, counters and adjustment values) are volatile.
+ * Configuration registers only change when the host writes them, so they are written through.
+ * The chip ID never changes.
+ *
+ * @param reg register address
+ * @return STC3115RegisterPolicy
+ */
+STC3115RegisterPolicy STC3115I2CCore::getRegisterPolicy(uint8_t reg) {
+    if (reg >= STC3115_REGISTER_MAP_SIZE) {
+        return STC3115_POLICY_VOLATILE;
+    }
+
+    if (reg == STC3115_REG_ID) {
+        return STC3115_POLICY_CACHE_FOREVER;
+    }
+
+    if ((reg >= STC3115_REG_CC_CNF_L && reg <= STC3115_REG_CURRENT_THRES) || reg == STC3115_REG_RELAX_MAX) {
+        return STC3115_POLICY_WRITE_THROUGH;
+    }
+
+    if (reg >= STC3115_REG_RAM0) {
+        return STC3115_POLICY_WRITE_THROUGH;
+    }
+
+    return STC3115_POLICY_VOLATILE;
+}
+
+/**
+ * @brief Copy a register range from the shadow if every byte of it is cacheable and valid.
+ *
+ * @param output array that will hold the result
+ * @param reg first register address
+ * @param length number of registers
+ * @return true if the read was served from the shadow
+ * @return false if the bus has to be read
+ */
+bool STC3115I2CCore::readFromCache(uint8_t* output, uint8_t reg, size_t length) {
+#if STC3115_ENABLE_REGISTER_CACHE
+    if (!cacheEnabled || length == 0 || reg + length > STC3115_REGISTER_MAP_SIZE) {
+        return false;
+    }
 
     for (size_t i = 0; i < length; i++) {
-        Wire.write(data[i]);
+        uint8_t current = reg + i;
+        if ((shadowValid[current / 32] & (static_cast<uint32_t>(1) << (current % 32))) == 0) {
+            return false;
+        }
     }
 
-    if (Wire.endTransmission() != 0) {
-        returnValue = false;
+    for (size_t i = 0; i < length; i++) {
+        output[i] = shadow[reg + i];
     }
 
-    return returnValue;
+    return true;
+#else
+    (void)output;
+    (void)reg;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * @brief Store the bytes of a successful bus transfer in the shadow, skipping volatile registers.
+ *
+ * @param reg first register address
+ * @param data transferred bytes
+ * @param length number of registers
+ */
+void STC3115I2CCore::updateCache(uint8_t reg, const uint8_t* data, size_t length) {
+#if STC3115_ENABLE_REGISTER_CACHE
+    if (!cacheEnabled) {
+        return;
+    }
+
+    for (size_t i = 0; i < length && reg + i < STC3115_REGISTER_MAP_SIZE; i++) {
+        uint8_t current = reg + i;
+        if (getRegisterPolicy(current) == STC3115_POLICY_VOLATILE) {
+            continue;
+        }
+
+        shadow[current] = data[i];
+        shadowValid[current / 32] |= static_cast<uint32_t>(1) << (current % 32);
+    }
+#else
+    (void)reg;
+    (void)data;
+    (void)length;
+#endif
 }
@@ -1,8 +1,14 @@
 #ifndef STC3115_I2C_CORE_FILE_H
 #define STC3115_I2C_CORE_FILE_H
 
-#include <Arduino.h>
+#include "STC3115_platform.h"
+#include "STC3115_types.h"
+
+#if defined(ARDUINO)
 #include <Wire.h>
+#else
+#include "STC3115LinuxI2C.h"
+#endif
 
 class STC3115I2CCore {
 public:
@@ -17,8 +23,36 @@ public:
     bool writeRegister(uint8_t reg, uint8_t data);
     bool writeRegisterInt(uint8_t reg, int data);
     bool writeRegister(uint8_t reg, uint8_t* data, size_t length);
+
+    void enableRegisterCache();
+    void disableRegisterCache();
+    void invalidateRegisterCache();
+    bool isRegisterCacheEnabled();
+    uint16_t getTransactionCount();
+    static STC3115RegisterPolicy getRegisterPolicy(uint8_t reg);
+
+#if !defined(ARDUINO)
+    void attachBus(STC3115I2CBus* bus);
+    STC3115I2CBus* getBus();
+    uint8_t getAddress();
+#endif
 protected:
+    bool busRead(uint8_t reg, uint8_t* output, uint8_t length);
+    bool busWrite(uint8_t reg, const uint8_t* data, size_t length);
+    bool readFromCache(uint8_t* output, uint8_t reg, size_t length);
+    void updateCache(uint8_t reg, const uint8_t* data, size_t length);
+
     uint8_t address;
+    uint16_t transactionCount;
+#if !defined(ARDUINO)
+    STC3115I2CBus* bus;
+#endif
+
+#if STC3115_ENABLE_REGISTER_CACHE
+    bool cacheEnabled;
+    uint8_t shadow[STC3115_REGISTER_MAP_SIZE];
+    uint32_t shadowValid[STC3115_REGISTER_MAP_SIZE / 32];
+#endif
 };
 
 #endif
@@ -0,0 +1,102 @@
+#include "STC3115I2CCore.h"
+#include "STC3115_registers.h"
+
+#if !defined(ARDUINO)
+
+/**
+ * @brief Attach the adapter the gauge is connected to. Must be called before begin().
+ *
+ * @param bus I2C adapter
+ */
+void STC3115I2CCore::attachBus(STC3115I2CBus* bus) {
+    this->bus = bus;
+    invalidateRegisterCache();
+}
+
+/**
+ * @brief Get the attached adapter
+ *
+ * @return STC3115I2CBus*
+ */
+STC3115I2CBus* STC3115I2CCore::getBus() {
+    return bus;
+}
+
+/**
+ * @brief Get the I2C address of the gauge
+ *
+ * @return uint8_t
+ */
+uint8_t STC3115I2CCore::getAddress() {
+    return address;
+}
+
+/**
+ * @brief Check whether the gauge answers on the attached adapter
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::beginI2C() {
+    uint8_t id = 0;
+    return busRead(STC3115_REG_ID, &id, 1);
+}
+
+/**
+ * @brief Read a register range with a single combined transfer: register write, repeated start, read.
+ *
+ * @param reg register to start reading
+ * @param output array that will hold the read result
+ * @param length length of the bytes
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::busRead(uint8_t reg, uint8_t* output, uint8_t length) {
+    if (bus == NULL) {
+        return false;
+    }
+
+    struct i2c_msg messages[2];
+    messages[0].addr = address;
+    messages[0].flags = 0;
+    messages[0].len = 1;
+    messages[0].buf = &reg;
+
+    messages[1].addr = address;
+    messages[1].flags = I2C_M_RD;
+    messages[1].len = length;
+    messages[1].buf = output;
+
+    return bus->transfer(messages, 2);
+}
+
+/**
+ * @brief Write a register range with a single transfer
+ *
+ * @param reg register to start writing
+ * @param data array of unsigned bytes
+ * @param length length of the array
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::busWrite(uint8_t reg, const uint8_t* data, size_t length) {
+    if (bus == NULL || length > STC3115_I2C_MAX_WRITE_LENGTH) {
+        return false;
+    }
+
+    uint8_t buffer[STC3115_I2C_MAX_WRITE_LENGTH + 1];
+    buffer[0] = reg;
+    for (size_t i = 0; i < length; i++) {
+        buffer[i + 1] = data[i];
+    }
+
+    struct i2c_msg message;
+    message.addr = address;
+    message.flags = 0;
+    message.len = length + 1;
+    message.buf = buffer;
+
+    return bus->transfer(&message, 1);
+}
+
+#endif
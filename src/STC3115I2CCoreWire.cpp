@@ -0,0 +1,74 @@
+#include "STC3115I2CCore.h"
+
+#if defined(ARDUINO)
+
+/**
+ * @brief Initialize I2C and check whether the address is available or not
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::beginI2C() {
+    bool result = true;
+    Wire.beginTransmission(address);
+
+    result = Wire.endTransmission() == 0;
+
+    return result;
+}
+
+/**
+ * @brief Read a register range from the bus through Wire. The read is attempted once; a short read fails.
+ *
+ * @param reg register to start reading
+ * @param output array that will hold the read result
+ * @param length length of the bytes
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::busRead(uint8_t reg, uint8_t* output, uint8_t length) {
+    bool returnValue = true;
+    uint8_t temp = 0;
+
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    if (Wire.endTransmission() != 0) {
+        returnValue = false;
+    } else if (Wire.requestFrom(address, length) != length) {
+        returnValue = false;
+    } else {
+        for (int i = 0; i < length; i++) {
+            temp = Wire.read();
+            output[i] = temp;
+        }
+    }
+
+    return returnValue;
+}
+
+/**
+ * @brief Write a register range to the bus through Wire
+ *
+ * @param reg register to start writing
+ * @param data array of unsigned bytes
+ * @param length length of the array
+ * @return true
+ * @return false
+ */
+bool STC3115I2CCore::busWrite(uint8_t reg, const uint8_t* data, size_t length) {
+    bool returnValue = true;
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+
+    for (size_t i = 0; i < length; i++) {
+        Wire.write(data[i]);
+    }
+
+    if (Wire.endTransmission() != 0) {
+        returnValue = false;
+    }
+
+    return returnValue;
+}
+
+#endif
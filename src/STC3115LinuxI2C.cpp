@@ -0,0 +1,268 @@
+#include "STC3115LinuxI2C.h"
+
+#if !defined(ARDUINO)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+STC3115I2CBus::STC3115I2CBus():
+ maxMessages(I2C_RDWR_IOCTL_MAX_MSGS) {}
+
+STC3115I2CBus::~STC3115I2CBus() {}
+
+/**
+ * @brief Limit the number of messages per combined transfer. Some adapters only support a write followed by a read.
+ *
+ * @param maxMessages maximum number of messages, at least 2
+ */
+void STC3115I2CBus::setMaxMessages(size_t maxMessages) {
+    this->maxMessages = maxMessages < 2 ? 2 : maxMessages;
+}
+
+/**
+ * @brief Get the maximum number of messages per combined transfer
+ *
+ * @return size_t
+ */
+size_t STC3115I2CBus::getMaxMessages() {
+    return maxMessages;
+}
+
+/**
+ * @brief Initialize the adapter for an i2c-dev device node. The device is opened by open().
+ *
+ * @param path device node, e.g. /dev/i2c-1
+ */
+STC3115LinuxI2CBus::STC3115LinuxI2CBus(const char* path):
+ path(path),
+ fd(-1) {}
+
+STC3115LinuxI2CBus::~STC3115LinuxI2CBus() {
+    close();
+}
+
+/**
+ * @brief Open the device node and check that the adapter supports combined I2C_RDWR transfers.
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115LinuxI2CBus::open() {
+    if (fd >= 0) {
+        return true;
+    }
+
+    fd = ::open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    unsigned long funcs = 0;
+    if (ioctl(fd, I2C_FUNCS, &funcs) < 0 || (funcs & I2C_FUNC_I2C) == 0) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Close the device node
+ *
+ */
+void STC3115LinuxI2CBus::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+/**
+ * @brief Check whether the device node is open
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115LinuxI2CBus::isOpen() {
+    return fd >= 0;
+}
+
+/**
+ * @brief Get the device node path
+ *
+ * @return const char*
+ */
+const char* STC3115LinuxI2CBus::getPath() {
+    return path;
+}
+
+/**
+ * @brief Execute the messages as a single I2C_RDWR ioctl
+ *
+ * @param messages messages to be transferred
+ * @param count number of messages
+ * @return true if every message was transferred
+ * @return false otherwise
+ */
+bool STC3115LinuxI2CBus::transfer(struct i2c_msg* messages, size_t count) {
+    if (fd < 0 || count == 0 || count > maxMessages) {
+        return false;
+    }
+
+    struct i2c_rdwr_ioctl_data data;
+    data.msgs = messages;
+    data.nmsgs = count;
+
+    int result;
+    do {
+        result = ioctl(fd, I2C_RDWR, &data);
+    } while (result < 0 && errno == EINTR);
+
+    return result == static_cast<int>(count);
+}
+
+/**
+ * @brief Initialize an empty batch
+ *
+ * @param bus adapter the batch is executed on
+ */
+STC3115I2CBatch::STC3115I2CBatch(STC3115I2CBus* bus):
+ bus(bus),
+ count(0),
+ transferCount(0) {}
+
+/**
+ * @brief Queue a register range read. The output buffer must stay valid until execute() returns.
+ *
+ * @param address I2C address of the gauge
+ * @param reg register to start reading
+ * @param output array that will hold the read result
+ * @param length length of the bytes
+ * @return true
+ * @return false if the batch is full
+ */
+bool STC3115I2CBatch::add(uint8_t address, uint8_t reg, uint8_t* output, uint8_t length) {
+    if (count >= STC3115_I2C_BATCH_MAX_READS || length == 0) {
+        return false;
+    }
+
+    registers[count] = reg;
+    results[count] = false;
+
+    struct i2c_msg* message = &messages[count * 2];
+    message[0].addr = address;
+    message[0].flags = 0;
+    message[0].len = 1;
+    message[0].buf = &registers[count];
+
+    message[1].addr = address;
+    message[1].flags = I2C_M_RD;
+    message[1].len = length;
+    message[1].buf = output;
+
+    count++;
+    return true;
+}
+
+/**
+ * @brief Execute every queued read.
+ *
+ * Reads are packed into as few combined transfers as the adapter allows. If the adapter rejects a combined
+ * transfer, the reads of that transfer are retried one by one and later transfers are limited to one read.
+ *
+ * @return true if every read succeeded
+ * @return false otherwise, see isReadOk()
+ */
+bool STC3115I2CBatch::execute() {
+    if (bus == NULL) {
+        return false;
+    }
+
+    bool returnValue = true;
+    size_t first = 0;
+
+    while (first < count) {
+        size_t readsPerTransfer = bus->getMaxMessages() / 2;
+        size_t chunk = count - first;
+        if (chunk > readsPerTransfer) {
+            chunk = readsPerTransfer;
+        }
+
+        if (!executeRange(first, chunk)) {
+            if (chunk > 1) {
+                bus->setMaxMessages(2);
+                for (size_t i = first; i < first + chunk; i++) {
+                    if (!executeRange(i, 1)) {
+                        returnValue = false;
+                    }
+                }
+            } else {
+                returnValue = false;
+            }
+        }
+
+        first += chunk;
+    }
+
+    return returnValue;
+}
+
+/**
+ * @brief Transfer a range of queued reads in one combined transfer
+ *
+ * @param first index of the first read
+ * @param reads number of reads
+ * @return true
+ * @return false
+ */
+bool STC3115I2CBatch::executeRange(size_t first, size_t reads) {
+    transferCount++;
+    bool ok = bus->transfer(&messages[first * 2], reads * 2);
+
+    for (size_t i = first; i < first + reads; i++) {
+        results[i] = ok;
+    }
+
+    return ok;
+}
+
+/**
+ * @brief Remove every queued read
+ *
+ */
+void STC3115I2CBatch::clear() {
+    count = 0;
+}
+
+/**
+ * @brief Get the number of queued reads
+ *
+ * @return size_t
+ */
+size_t STC3115I2CBatch::size() {
+    return count;
+}
+
+/**
+ * @brief Check the result of a read after execute()
+ *
+ * @param index position of the read in the batch
+ * @return true
+ * @return false
+ */
+bool STC3115I2CBatch::isReadOk(size_t index) {
+    return index < count && results[index];
+}
+
+/**
+ * @brief Get the number of transfers issued by this batch so far
+ *
+ * @return uint32_t
+ */
+uint32_t STC3115I2CBatch::getTransferCount() {
+    return transferCount;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef STC3115_LINUX_I2C_H
+#define STC3115_LINUX_I2C_H
+
+#if !defined(ARDUINO)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#ifndef STC3115_I2C_BATCH_MAX_READS
+#define STC3115_I2C_BATCH_MAX_READS 16
+#endif
+
+#define STC3115_I2C_MAX_WRITE_LENGTH 64
+
+/**
+ * @brief I2C adapter used by STC3115I2CCore on Linux hosts.
+ *
+ * A transfer is a list of i2c_msg executed as one combined transaction: messages are separated
+ * by repeated starts and the bus is released only after the last one.
+ */
+class STC3115I2CBus {
+public:
+    STC3115I2CBus();
+    virtual ~STC3115I2CBus();
+
+    virtual bool transfer(struct i2c_msg* messages, size_t count) = 0;
+
+    void setMaxMessages(size_t maxMessages);
+    size_t getMaxMessages();
+protected:
+    size_t maxMessages;
+};
+
+/**
+ * @brief I2C adapter backed by a Linux i2c-dev character device, e.g. /dev/i2c-1 or an i2c-stub bus.
+ *
+ */
+class STC3115LinuxI2CBus : public STC3115I2CBus {
+public:
+    STC3115LinuxI2CBus(const char* path);
+    virtual ~STC3115LinuxI2CBus();
+
+    bool open();
+    void close();
+    bool isOpen();
+    const char* getPath();
+
+    virtual bool transfer(struct i2c_msg* messages, size_t count);
+private:
+    const char* path;
+    int fd;
+};
+
+/**
+ * @brief Collects register reads for one or more gauges on a bus and issues them with as few transfers as possible.
+ *
+ */
+class STC3115I2CBatch {
+public:
+    STC3115I2CBatch(STC3115I2CBus* bus);
+
+    bool add(uint8_t address, uint8_t reg, uint8_t* output, uint8_t length);
+    bool execute();
+    void clear();
+    size_t size();
+    bool isReadOk(size_t index);
+    uint32_t getTransferCount();
+private:
+    bool executeRange(size_t first, size_t count);
+
+    STC3115I2CBus* bus;
+    uint8_t registers[STC3115_I2C_BATCH_MAX_READS];
+    bool results[STC3115_I2C_BATCH_MAX_READS];
+    struct i2c_msg messages[STC3115_I2C_BATCH_MAX_READS * 2];
+    size_t count;
+    uint32_t transferCount;
+};
+
+#endif
+
+#endif
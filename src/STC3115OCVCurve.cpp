@@ -0,0 +1,70 @@
+#include "STC3115OCVCurve.h"
+
+static const STC3115OCVPoint liIonCurve[] STC3115_PROGMEM = {
+    {3300, 0}, {3540, 50}, {3610, 100}, {3690, 200}, {3740, 300}, {3780, 400},
+    {3820, 500}, {3870, 600}, {3930, 700}, {4000, 800}, {4080, 900}, {4180, 1000}
+};
+
+static const STC3115OCVPoint liFePO4Curve[] STC3115_PROGMEM = {
+    {2800, 0}, {3000, 50}, {3200, 100}, {3250, 200}, {3270, 300}, {3290, 400},
+    {3300, 500}, {3310, 600}, {3330, 700}, {3340, 800}, {3350, 900}, {3400, 1000}
+};
+
+STC3115OCVCurve::STC3115OCVCurve():
+ curve(liIonCurve),
+ size(sizeof(liIonCurve) / sizeof(liIonCurve[0])) {}
+
+/**
+ * @brief Select the built-in curve of a chemistry. STC3115_CHEMISTRY_NONE selects the Li-ion curve.
+ *
+ * @param chemistry battery chemistry
+ */
+void STC3115OCVCurve::setChemistry(STC3115Chemistry chemistry) {
+    if (chemistry == STC3115_CHEMISTRY_LIFEPO4) {
+        setCurve(liFePO4Curve, sizeof(liFePO4Curve) / sizeof(liFePO4Curve[0]));
+    } else {
+        setCurve(liIonCurve, sizeof(liIonCurve) / sizeof(liIonCurve[0]));
+    }
+}
+
+/**
+ * @brief Use a characterized curve of the cell. On AVR the table must be in flash (STC3115_PROGMEM).
+ *
+ * @param curve points in increasing voltage
+ * @param size number of points, at least 2
+ */
+void STC3115OCVCurve::setCurve(const STC3115OCVPoint* curve, uint8_t size) {
+    if (curve == NULL || size < 2) {
+        return;
+    }
+
+    this->curve = curve;
+    this->size = size;
+}
+
+/**
+ * @brief Interpolate the state of charge of an open-circuit voltage
+ *
+ * @param voltage open-circuit voltage in mV
+ * @return int SOC in 0.1%, clamped to the ends of the curve
+ */
+int STC3115OCVCurve::getSOC(int voltage) {
+    STC3115OCVPoint lower;
+    STC3115OCVPoint upper;
+
+    stc3115_read_flash(&lower, &curve[0], sizeof(STC3115OCVPoint));
+    if (voltage <= lower.Voltage) {
+        return lower.SOC;
+    }
+
+    for (uint8_t i = 1; i < size; i++) {
+        stc3115_read_flash(&upper, &curve[i], sizeof(STC3115OCVPoint));
+        if (voltage < upper.Voltage) {
+            return lower.SOC + static_cast<long>(voltage - lower.Voltage) * (upper.SOC - lower.SOC) / (upper.Voltage - lower.Voltage);
+        }
+
+        lower = upper;
+    }
+
+    return lower.SOC;
+}
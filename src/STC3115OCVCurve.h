@@ -0,0 +1,35 @@
+#ifndef STC3115_OCV_CURVE_H
+#define STC3115_OCV_CURVE_H
+
+#include <stdint.h>
+#include "STC3115_platform.h"
+#include "STC3115Derating.h"
+
+/**
+ * @brief Point of an open-circuit voltage curve: Voltage in mV, SOC in 0.1%. Points are in increasing voltage.
+ *
+ */
+typedef struct {
+    int16_t Voltage;
+    int16_t SOC;
+} STC3115OCVPoint;
+
+/**
+ * @brief State of charge as a function of the open-circuit voltage, interpolated from a characterized curve in flash.
+ *
+ * Used for provisional estimates before the gauge has converged. The curve follows the chemistry selected with
+ * STC3115::setChemistry(); a cell-specific curve can be set instead.
+ */
+class STC3115OCVCurve {
+public:
+    STC3115OCVCurve();
+
+    void setChemistry(STC3115Chemistry chemistry);
+    void setCurve(const STC3115OCVPoint* curve, uint8_t size);
+    int getSOC(int voltage);
+private:
+    const STC3115OCVPoint* curve;
+    uint8_t size;
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "STC3115Pack.h"
+
+/**
+ * @brief Initialize an empty pack
+ *
+ * @param topology how the cells are connected
+ */
+STC3115Pack::STC3115Pack(STC3115PackTopology topology):
+ topology(topology),
+ count(0),
+ validCount(0),
+ weightedSOC(0),
+ chargeSum(0),
+ capacitySum(0),
+ voltageSum(0),
+ currentSum(0),
+ minCharge(0),
+ minRemTime(-1) {
+    rescan();
+    summarize();
+}
+
+/**
+ * @brief Add a cell gauge to the pack
+ *
+ * @param gauge gauge of the cell
+ * @return true
+ * @return false if the pack already has STC3115_PACK_MAX_CELLS cells
+ */
+bool STC3115Pack::add(STC3115* gauge) {
+    if (gauge == NULL || count >= STC3115_PACK_MAX_CELLS) {
+        return false;
+    }
+
+    Member* member = &members[count++];
+    member->gauge = gauge;
+    member->version = 0;
+    member->valid = false;
+    summary.Cells = count;
+
+    return true;
+}
+
+/**
+ * @brief Get the number of cells
+ *
+ * @return uint8_t
+ */
+uint8_t STC3115Pack::size() {
+    return count;
+}
+
+/**
+ * @brief Fold in every cell that published a new snapshot since the last call
+ *
+ * @return true if at least one cell changed
+ * @return false otherwise
+ */
+bool STC3115Pack::update() {
+    bool changed = false;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (members[i].gauge->getSnapshotVersion() != members[i].version || !members[i].valid) {
+            changed |= updateMember(i);
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * @brief Fold in the latest snapshot of one cell, e.g. from the callback of its sampler
+ *
+ * @param index position of the cell in the pack
+ * @return true if the cell changed
+ * @return false if there was nothing new or the snapshot could not be read
+ */
+bool STC3115Pack::updateMember(uint8_t index) {
+    if (index >= count) {
+        return false;
+    }
+
+    Member* member = &members[index];
+    STC3115BatteryData data;
+    stc3115_seq_t version;
+
+    if (!member->gauge->getSnapshot(&data, &version) || version == 0) {
+        return false;
+    }
+
+    if (member->valid && version == member->version) {
+        return false;
+    }
+
+    bool wasValid = member->valid;
+    int oldSOC = member->soc;
+    int oldCharge = member->charge;
+    int oldRemTime = member->remTime;
+
+    if (wasValid) {
+        apply(member, -1);
+    } else {
+        validCount++;
+    }
+
+    member->version = version;
+    member->valid = true;
+    member->soc = data.SOC;
+    member->charge = data.ChargeValue;
+    member->capacity = member->gauge->getCapacity();
+    member->voltage = data.Voltage;
+    member->current = data.Current;
+    member->remTime = data.RemTime;
+    apply(member, 1);
+
+    bool extremeLost = wasValid && (
+        (index == summary.MinCell && member->soc > oldSOC) ||
+        (index == summary.MaxCell && member->soc < oldSOC) ||
+        (oldCharge == minCharge && member->charge > oldCharge) ||
+        (oldRemTime >= 0 && oldRemTime == minRemTime && member->remTime != oldRemTime));
+
+    if (!wasValid || extremeLost) {
+        rescan();
+    } else {
+        if (member->soc < summary.MinSOC) {
+            summary.MinSOC = member->soc;
+            summary.MinCell = index;
+        }
+
+        if (member->soc > summary.MaxSOC) {
+            summary.MaxSOC = member->soc;
+            summary.MaxCell = index;
+        }
+
+        if (member->charge < minCharge) {
+            minCharge = member->charge;
+        }
+
+        if (member->remTime >= 0 && (minRemTime < 0 || member->remTime < minRemTime)) {
+            minRemTime = member->remTime;
+        }
+    }
+
+    summarize();
+    return true;
+}
+
+/**
+ * @brief Get the aggregated state of the pack
+ *
+ * @return const STC3115PackSummary&
+ */
+const STC3115PackSummary& STC3115Pack::getSummary() {
+    return summary;
+}
+
+/**
+ * @brief Add (sign 1) or remove (sign -1) the contribution of a cell to the pack sums
+ *
+ */
+void STC3115Pack::apply(Member* member, int sign) {
+    weightedSOC += sign * static_cast<long>(member->soc) * member->capacity;
+    chargeSum += sign * member->charge;
+    capacitySum += sign * member->capacity;
+    voltageSum += sign * member->voltage;
+    currentSum += sign * member->current;
+}
+
+/**
+ * @brief Recompute minimum and maximum values over every valid cell
+ *
+ */
+void STC3115Pack::rescan() {
+    summary.MinSOC = MAX_SOC;
+    summary.MaxSOC = 0;
+    summary.MinCell = 0;
+    summary.MaxCell = 0;
+    minCharge = 0;
+    minRemTime = -1;
+
+    bool first = true;
+    for (uint8_t i = 0; i < count; i++) {
+        Member* member = &members[i];
+        if (!member->valid) {
+            continue;
+        }
+
+        if (first || member->soc < summary.MinSOC) {
+            summary.MinSOC = member->soc;
+            summary.MinCell = i;
+        }
+
+        if (first || member->soc > summary.MaxSOC) {
+            summary.MaxSOC = member->soc;
+            summary.MaxCell = i;
+        }
+
+        if (first || member->charge < minCharge) {
+            minCharge = member->charge;
+        }
+
+        if (member->remTime >= 0 && (minRemTime < 0 || member->remTime < minRemTime)) {
+            minRemTime = member->remTime;
+        }
+
+        first = false;
+    }
+}
+
+/**
+ * @brief Derive the pack values from the sums and extremes
+ *
+ */
+void STC3115Pack::summarize() {
+    summary.Cells = count;
+    summary.ValidCells = validCount;
+    summary.Imbalance = validCount > 0 ? summary.MaxSOC - summary.MinSOC : 0;
+
+    if (validCount == 0) {
+        summary.SOC = 0;
+        summary.RemainingCharge = 0;
+        summary.Capacity = 0;
+        summary.Voltage = 0;
+        summary.Current = 0;
+        summary.RemTime = -1;
+        return;
+    }
+
+    if (topology == STC3115_PACK_SERIES) {
+        summary.SOC = summary.MinSOC;
+        summary.RemainingCharge = minCharge;
+        summary.Capacity = capacitySum / validCount;
+        summary.Voltage = voltageSum;
+        summary.Current = currentSum / validCount;
+        summary.RemTime = minRemTime;
+    } else {
+        summary.SOC = capacitySum > 0 ? weightedSOC / capacitySum : 0;
+        summary.RemainingCharge = chargeSum;
+        summary.Capacity = capacitySum;
+        summary.Voltage = voltageSum / validCount;
+        summary.Current = currentSum;
+        summary.RemTime = currentSum < 0 ? chargeSum * 60 / -currentSum : -1;
+    }
+}
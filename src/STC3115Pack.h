@@ -0,0 +1,88 @@
+#ifndef STC3115_PACK_H
+#define STC3115_PACK_H
+
+#include "STC3115.h"
+
+#ifndef STC3115_PACK_MAX_CELLS
+#define STC3115_PACK_MAX_CELLS 32
+#endif
+
+/**
+ * @brief How the cells of a pack are connected
+ *
+ */
+typedef enum {
+    STC3115_PACK_SERIES = 0,
+    STC3115_PACK_PARALLEL
+} STC3115PackTopology;
+
+/**
+ * @brief Aggregated state of a pack.
+ *
+ * Series packs report the weakest cell SOC and remaining charge, the summed voltage, and the average current and capacity.
+ * Parallel packs report the capacity-weighted SOC, the summed remaining charge and current and the average voltage.
+ * RemTime is the worst-case remaining time in minutes, -1 when not discharging or unknown.
+ */
+typedef struct {
+    int SOC;
+    int RemainingCharge;
+    int Capacity;
+    int Voltage;
+    int Current;
+    int RemTime;
+    int MinSOC;
+    int MaxSOC;
+    int Imbalance;
+    uint8_t MinCell;
+    uint8_t MaxCell;
+    uint8_t Cells;
+    uint8_t ValidCells;
+} STC3115PackSummary;
+
+/**
+ * @brief Aggregates the snapshots of several gauges into pack-level values.
+ *
+ * Sums are updated by the difference of the member that changed. Minimum and maximum are only rescanned when
+ * the member holding them moves away, so a new sample usually costs a constant amount of work.
+ */
+class STC3115Pack {
+public:
+    STC3115Pack(STC3115PackTopology topology = STC3115_PACK_SERIES);
+
+    bool add(STC3115* gauge);
+    uint8_t size();
+    bool update();
+    bool updateMember(uint8_t index);
+    const STC3115PackSummary& getSummary();
+private:
+    struct Member {
+        STC3115* gauge;
+        stc3115_seq_t version;
+        bool valid;
+        int soc;
+        int charge;
+        int capacity;
+        int voltage;
+        int current;
+        int remTime;
+    };
+
+    void apply(Member* member, int sign);
+    void rescan();
+    void summarize();
+
+    STC3115PackTopology topology;
+    Member members[STC3115_PACK_MAX_CELLS];
+    uint8_t count;
+    uint8_t validCount;
+    long weightedSOC;
+    long chargeSum;
+    long capacitySum;
+    long voltageSum;
+    long currentSum;
+    int minCharge;
+    int minRemTime;
+    STC3115PackSummary summary;
+};
+
+#endif
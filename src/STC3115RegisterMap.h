@@ -0,0 +1,222 @@
+#ifndef STC3115_REGISTER_MAP_H
+#define STC3115_REGISTER_MAP_H
+
+#include <stdint.h>
+#include "STC3115_constants.h"
+#include "STC3115_registers.h"
+#include "STC3115_types.h"
+
+/**
+ * Measurement fields of the register map, in address order:
+ * name, first register, length in bytes, significant bits, signed, conversion factor (0 for none), factor divided
+ * by the sense resistor, multiplier, divisor.
+ *
+ * A field decodes to round(convert(raw, factor) * multiplier / divisor), where convert() is the 12-bit fixed point
+ * scaling of the gauge. Adding a field here gives it a decoder and a place in the read spans; its
+ * STC3115_FIELD_* mask in STC3115_constants.h must be 1 << its position.
+ */
+#define STC3115_FIELD_TABLE(FIELD) \
+    FIELD(SOC,         STC3115_REG_SOC_L,       2, 16, false, 0,             false, 10, 512) \
+    FIELD(COUNTER,     STC3115_REG_COUNTER_L,   2, 16, false, 0,             false, 1,  1) \
+    FIELD(CURRENT,     STC3115_REG_CURRENT_L,   2, 14, true,  CurrentFactor, true,  1,  1) \
+    FIELD(VOLTAGE,     STC3115_REG_VOLTAGE_L,   2, 12, true,  VoltageFactor, false, 1,  1) \
+    FIELD(TEMPERATURE, STC3115_REG_TEMPERATURE, 1, 8,  true,  0,             false, 10, 1) \
+    FIELD(OCV,         STC3115_REG_OCV_L,       2, 14, true,  VoltageFactor, false, 1,  4)
+
+/**
+ * @brief Position of a field in STC3115_FIELD_TABLE
+ *
+ */
+typedef enum {
+#define STC3115_FIELD_INDEX(name, address, length, bits, isSigned, factor, perSense, multiplier, divisor) STC3115_FIELD_INDEX_##name,
+    STC3115_FIELD_TABLE(STC3115_FIELD_INDEX)
+#undef STC3115_FIELD_INDEX
+    STC3115_FIELD_INDEX_END
+} STC3115FieldIndex;
+
+/**
+ * @brief Description of a measurement field
+ *
+ */
+typedef struct {
+    uint8_t Address;
+    uint8_t Length;
+    uint8_t Bits;
+    bool Signed;
+    uint16_t Factor;
+    bool PerSense;
+    uint16_t Multiplier;
+    uint16_t Divisor;
+} STC3115FieldDescriptor;
+
+/**
+ * @brief Get the descriptor of a field. Folds to constants when the index is known at compile time, so the
+ * table itself never occupies RAM.
+ *
+ * @param index position in STC3115_FIELD_TABLE
+ * @return STC3115FieldDescriptor
+ */
+constexpr STC3115FieldDescriptor stc3115Field(uint8_t index) {
+#define STC3115_FIELD_DESCRIPTOR(name, address, length, bits, isSigned, factor, perSense, multiplier, divisor) \
+    index == STC3115_FIELD_INDEX_##name ? STC3115FieldDescriptor{address, length, bits, isSigned, factor, perSense, multiplier, divisor} :
+    return STC3115_FIELD_TABLE(STC3115_FIELD_DESCRIPTOR) STC3115FieldDescriptor{0, 0, 0, false, 0, false, 1, 1};
+#undef STC3115_FIELD_DESCRIPTOR
+}
+
+#define STC3115_FIELD_MASK_CHECK(name, address, length, bits, isSigned, factor, perSense, multiplier, divisor) \
+    static_assert(STC3115_FIELD_##name == (1 << STC3115_FIELD_INDEX_##name), "STC3115_FIELD_" #name " does not match its table position"); \
+    static_assert(STC3115_FIELD_INDEX_##name == 0 || stc3115Field(STC3115_FIELD_INDEX_##name).Address >= \
+        stc3115Field(STC3115_FIELD_INDEX_##name - 1).Address + stc3115Field(STC3115_FIELD_INDEX_##name - 1).Length, \
+        "STC3115_FIELD_TABLE must be in address order");
+STC3115_FIELD_TABLE(STC3115_FIELD_MASK_CHECK)
+#undef STC3115_FIELD_MASK_CHECK
+
+static_assert(STC3115_FIELD_INDEX_END == STC3115_FIELD_COUNT, "STC3115_FIELD_COUNT does not match STC3115_FIELD_TABLE");
+static_assert(STC3115_FIELD_ALL == (1 << STC3115_FIELD_COUNT) - 1, "STC3115_FIELD_ALL does not match STC3115_FIELD_TABLE");
+
+/**
+ * @brief End address of a field, one past its last register
+ *
+ */
+constexpr uint8_t stc3115FieldEnd(uint8_t index) {
+    return stc3115Field(index).Address + stc3115Field(index).Length;
+}
+
+/**
+ * @brief Size of a buffer indexed by register address that holds every field
+ *
+ */
+#define STC3115_FIELD_BUFFER_SIZE stc3115FieldEnd(STC3115_FIELD_COUNT - 1)
+
+/*
+ * Read spans. Fields are visited in address order; a field joins the previous span when the gap between them is
+ * at most STC3115_READ_MERGE_GAP bytes, because clocking a few unused bytes is cheaper than addressing the device
+ * again. lastEnd is the end of the open span, or -1 before the first one.
+ */
+
+constexpr bool stc3115FieldSelected(uint8_t fields, uint8_t index) {
+    return (fields & (1 << index)) != 0;
+}
+
+constexpr bool stc3115FieldJoins(uint8_t index, int lastEnd) {
+    return lastEnd >= 0 && stc3115Field(index).Address <= lastEnd + STC3115_READ_MERGE_GAP;
+}
+
+constexpr uint8_t stc3115SpanCountFrom(uint8_t fields, uint8_t index, int lastEnd) {
+    return index >= STC3115_FIELD_COUNT ? 0 :
+        !stc3115FieldSelected(fields, index) ? stc3115SpanCountFrom(fields, index + 1, lastEnd) :
+        (stc3115FieldJoins(index, lastEnd) ? 0 : 1) + stc3115SpanCountFrom(fields, index + 1, stc3115FieldEnd(index));
+}
+
+constexpr uint8_t stc3115SpanStartFrom(uint8_t fields, uint8_t span, uint8_t index, int lastEnd) {
+    return index >= STC3115_FIELD_COUNT ? 0 :
+        !stc3115FieldSelected(fields, index) ? stc3115SpanStartFrom(fields, span, index + 1, lastEnd) :
+        stc3115FieldJoins(index, lastEnd) ? stc3115SpanStartFrom(fields, span, index + 1, stc3115FieldEnd(index)) :
+        span == 0 ? stc3115Field(index).Address : stc3115SpanStartFrom(fields, span - 1, index + 1, stc3115FieldEnd(index));
+}
+
+constexpr uint8_t stc3115SpanEndFrom(uint8_t fields, int span, uint8_t index, int lastEnd) {
+    return index >= STC3115_FIELD_COUNT ? (span == 0 ? lastEnd : 0) :
+        !stc3115FieldSelected(fields, index) ? stc3115SpanEndFrom(fields, span, index + 1, lastEnd) :
+        stc3115FieldJoins(index, lastEnd) ? stc3115SpanEndFrom(fields, span, index + 1, stc3115FieldEnd(index)) :
+        span == 0 && lastEnd >= 0 ? lastEnd : stc3115SpanEndFrom(fields, lastEnd >= 0 ? span - 1 : span, index + 1, stc3115FieldEnd(index));
+}
+
+/**
+ * @brief Number of bus transactions needed to read a set of fields
+ *
+ * @param fields combination of STC3115_FIELD_* flags
+ */
+constexpr uint8_t stc3115SpanCount(uint8_t fields) {
+    return stc3115SpanCountFrom(fields, 0, -1);
+}
+
+/**
+ * @brief First register of a read span
+ *
+ * @param fields combination of STC3115_FIELD_* flags
+ * @param span span number, below stc3115SpanCount(fields)
+ */
+constexpr uint8_t stc3115SpanStart(uint8_t fields, uint8_t span) {
+    return stc3115SpanStartFrom(fields, span, 0, -1);
+}
+
+/**
+ * @brief Number of registers of a read span
+ *
+ * @param fields combination of STC3115_FIELD_* flags
+ * @param span span number, below stc3115SpanCount(fields)
+ */
+constexpr uint8_t stc3115SpanLength(uint8_t fields, uint8_t span) {
+    return stc3115SpanEndFrom(fields, span, 0, -1) - stc3115SpanStart(fields, span);
+}
+
+static_assert(stc3115SpanCount(STC3115_FIELD_ALL) == 1, "a full measurement set should be one transaction");
+static_assert(stc3115SpanStart(STC3115_FIELD_ALL, 0) == STC3115_REG_SOC_L && stc3115SpanLength(STC3115_FIELD_ALL, 0) == 13,
+    "unexpected span for a full measurement set");
+static_assert(stc3115SpanCount(STC3115_FIELD_SOC | STC3115_FIELD_OCV) == 2, "SOC and OCV are too far apart to share a span");
+
+/**
+ * @brief Fixed point scaling used by the gauge for voltage and current: round(value * factor / 4096).
+ *
+ * @param value raw register value
+ * @param factor conversion factor
+ * @return long
+ */
+inline long stc3115Convert(long value, uint16_t factor) {
+    long v = (value * factor) >> 11;
+    return (v + 1) / 2;
+}
+
+/**
+ * @brief Extract the raw value of a field, sign-extended if the field is signed.
+ *
+ * @tparam Index position in STC3115_FIELD_TABLE
+ * @param registers buffer indexed by register address
+ * @return long
+ */
+template <uint8_t Index>
+inline long stc3115ReadField(const uint8_t* registers) {
+    static_assert(Index < STC3115_FIELD_COUNT, "unknown field");
+
+    long value = 0;
+    for (uint8_t i = stc3115Field(Index).Length; i > 0; i--) {
+        value = (value << 8) | registers[stc3115Field(Index).Address + i - 1];
+    }
+
+    if (stc3115Field(Index).Bits < 8 * stc3115Field(Index).Length) {
+        value &= (1L << stc3115Field(Index).Bits) - 1;
+    }
+
+    if (stc3115Field(Index).Signed && value >= (1L << (stc3115Field(Index).Bits - 1))) {
+        value -= 1L << stc3115Field(Index).Bits;
+    }
+
+    return value;
+}
+
+/**
+ * @brief Decode a field to its physical unit
+ *
+ * @tparam Index position in STC3115_FIELD_TABLE
+ * @param registers buffer indexed by register address
+ * @param rSense sense resistor in mOhm, used by fields whose factor depends on it
+ * @return long
+ */
+template <uint8_t Index>
+inline long stc3115DecodeField(const uint8_t* registers, int rSense) {
+    long value = stc3115ReadField<Index>(registers);
+
+    if (stc3115Field(Index).Factor != 0) {
+        uint16_t factor = stc3115Field(Index).Factor;
+        if (stc3115Field(Index).PerSense) {
+            factor = rSense != 0 ? factor / rSense : 0;
+        }
+
+        value = stc3115Convert(value, factor);
+    }
+
+    return (value * stc3115Field(Index).Multiplier + stc3115Field(Index).Divisor / 2) / stc3115Field(Index).Divisor;
+}
+
+#endif
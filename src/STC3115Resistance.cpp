@@ -0,0 +1,240 @@
+#include "STC3115Resistance.h"
+#include "STC3115_registers.h"
+
+STC3115RintEstimator::STC3115RintEstimator():
+ head(0),
+ count(0),
+ enabled(false),
+ synced(false),
+ adjusted(false),
+ lastVoltage(0),
+ lastCurrent(0),
+ lastCounter(0),
+ lastAdjustment(0),
+ accepted(0),
+ rejected(0) {
+    for (uint8_t i = 0; i < STC3115_RINT_SAMPLES; i++) {
+        samples[i] = 0;
+    }
+}
+
+/**
+ * @brief Start sampling current steps and proposing VM_CNF adjustments
+ *
+ */
+void STC3115RintEstimator::enable() {
+    enabled = true;
+    synced = false;
+}
+
+/**
+ * @brief Stop sampling. The estimate is kept.
+ *
+ */
+void STC3115RintEstimator::disable() {
+    enabled = false;
+}
+
+/**
+ * @brief Check whether the estimator is sampling
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115RintEstimator::isEnabled() {
+    return enabled;
+}
+
+/**
+ * @brief Compare a measurement set with the previous conversion and record a resistance sample on a current step.
+ *
+ * Measurement sets of the same conversion are ignored. Voltage mode reports no current, so it is skipped too.
+ *
+ * @param data latest measurement set of a running gauge
+ * @return true if a sample was accepted
+ * @return false otherwise
+ */
+bool STC3115RintEstimator::update(const STC3115BatteryData& data) {
+    if (!enabled) {
+        return false;
+    }
+
+    if ((data.StatusWord & STC3115_VMODE) != 0) {
+        synced = false;
+        return false;
+    }
+
+    if (synced && data.ConvCounter == lastCounter) {
+        return false;
+    }
+
+    bool consecutive = synced && ((data.ConvCounter - lastCounter) & 0xffff) == 1;
+    int deltaVoltage = data.Voltage - lastVoltage;
+    int deltaCurrent = data.Current - lastCurrent;
+
+    lastVoltage = data.Voltage;
+    lastCurrent = data.Current;
+    lastCounter = data.ConvCounter;
+    synced = true;
+
+    if (!consecutive || (deltaCurrent < STC3115_RINT_MIN_STEP && deltaCurrent > -STC3115_RINT_MIN_STEP)) {
+        return false;
+    }
+
+    long resistance = static_cast<long>(deltaVoltage) * 1000 / deltaCurrent;
+    if (resistance < STC3115_RINT_MIN || resistance > STC3115_RINT_MAX) {
+        rejected++;
+        return false;
+    }
+
+    samples[head] = resistance;
+    head = (head + 1) % STC3115_RINT_SAMPLES;
+    if (count < STC3115_RINT_SAMPLES) {
+        count++;
+    }
+
+    accepted++;
+    return true;
+}
+
+/**
+ * @brief Compute the VM_CNF value the gauge should use next.
+ *
+ * @param capacity nominal capacity in mAh
+ * @param vmConf VM_CNF value currently programmed in the gauge
+ * @param next pointer to the variable that will hold the new VM_CNF value
+ * @return true if VM_CNF should be rewritten with next
+ * @return false if the estimate is not ready, close enough, or the last adjustment is too recent
+ */
+bool STC3115RintEstimator::getAdjustment(int capacity, int vmConf, int* next) {
+    if (!enabled || count < STC3115_RINT_SAMPLES || capacity <= 0) {
+        return false;
+    }
+
+    if (adjusted && ((lastCounter - lastAdjustment) & 0xffff) < STC3115_RINT_ADJUST_INTERVAL) {
+        return false;
+    }
+
+    long target = getResistance();
+    long applied = fromVMConf(capacity, vmConf);
+    long difference = target - applied;
+
+    if (applied > 0) {
+        if ((difference < 0 ? -difference : difference) * 100 <= applied * STC3115_RINT_THRESHOLD) {
+            return false;
+        }
+
+        long limit = applied * STC3115_RINT_MAX_ADJUSTMENT / 100;
+        if (limit < 1) {
+            limit = 1;
+        }
+
+        if (difference > limit) {
+            difference = limit;
+        } else if (difference < -limit) {
+            difference = -limit;
+        }
+    }
+
+    int value = toVMConf(capacity, applied + difference);
+    if (value == vmConf) {
+        return false;
+    }
+
+    *next = value;
+    adjusted = true;
+    lastAdjustment = lastCounter;
+
+    return true;
+}
+
+/**
+ * @brief Forget the previous conversion after the gauge was restarted and its conversion counter reset.
+ *
+ */
+void STC3115RintEstimator::resync() {
+    synced = false;
+    adjusted = false;
+}
+
+/**
+ * @brief Drop every sample, e.g. after the battery was replaced.
+ *
+ */
+void STC3115RintEstimator::clear() {
+    head = 0;
+    count = 0;
+    accepted = 0;
+    rejected = 0;
+    synced = false;
+    adjusted = false;
+}
+
+/**
+ * @brief Get the estimated internal resistance
+ *
+ * @return int resistance in mOhm, or 0 until STC3115_RINT_SAMPLES samples were accepted
+ */
+int STC3115RintEstimator::getResistance() {
+    if (count < STC3115_RINT_SAMPLES) {
+        return 0;
+    }
+
+    int16_t sorted[STC3115_RINT_SAMPLES];
+    for (uint8_t i = 0; i < count; i++) {
+        int16_t value = samples[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+
+        sorted[j] = value;
+    }
+
+    return sorted[count / 2];
+}
+
+/**
+ * @brief Get the number of accepted samples since the last clear()
+ *
+ * @return uint16_t
+ */
+uint16_t STC3115RintEstimator::getSampleCount() {
+    return accepted;
+}
+
+/**
+ * @brief Get the number of current steps rejected as implausible since the last clear()
+ *
+ * @return uint16_t
+ */
+uint16_t STC3115RintEstimator::getRejectCount() {
+    return rejected;
+}
+
+/**
+ * @brief Convert an internal resistance to the VM_CNF register value, like initConfig() does for BATT_RINT.
+ *
+ * @param capacity nominal capacity in mAh
+ * @param resistance internal resistance in mOhm
+ * @return int
+ */
+int STC3115RintEstimator::toVMConf(int capacity, int resistance) {
+    return (static_cast<long>(capacity) * resistance * 50 + 24444) / 48889;
+}
+
+/**
+ * @brief Convert a VM_CNF register value back to the internal resistance it was computed from.
+ *
+ * @param capacity nominal capacity in mAh
+ * @param vmConf VM_CNF register value
+ * @return int resistance in mOhm
+ */
+int STC3115RintEstimator::fromVMConf(int capacity, int vmConf) {
+    if (capacity <= 0) {
+        return 0;
+    }
+
+    return (static_cast<long>(vmConf) * 48889 + static_cast<long>(capacity) * 25) / (static_cast<long>(capacity) * 50);
+}
@@ -0,0 +1,78 @@
+#ifndef STC3115_RESISTANCE_H
+#define STC3115_RESISTANCE_H
+
+#include <stdint.h>
+#include "STC3115_types.h"
+
+#ifndef STC3115_RINT_MIN_STEP
+#define STC3115_RINT_MIN_STEP 100
+#endif
+
+#ifndef STC3115_RINT_MIN
+#define STC3115_RINT_MIN 20
+#endif
+
+#ifndef STC3115_RINT_MAX
+#define STC3115_RINT_MAX 2000
+#endif
+
+#ifndef STC3115_RINT_SAMPLES
+#define STC3115_RINT_SAMPLES 5
+#endif
+
+#ifndef STC3115_RINT_THRESHOLD
+#define STC3115_RINT_THRESHOLD 10
+#endif
+
+#ifndef STC3115_RINT_MAX_ADJUSTMENT
+#define STC3115_RINT_MAX_ADJUSTMENT 10
+#endif
+
+#ifndef STC3115_RINT_ADJUST_INTERVAL
+#define STC3115_RINT_ADJUST_INTERVAL 240
+#endif
+
+/**
+ * @brief Estimates the internal resistance of the battery from current steps and derives the VM_CNF value.
+ *
+ * Two consecutive conversions whose current differs by at least STC3115_RINT_MIN_STEP mA give one sample of
+ * dV/dI. Samples outside STC3115_RINT_MIN..STC3115_RINT_MAX mOhm are rejected, and the estimate is the median of
+ * the last STC3115_RINT_SAMPLES accepted samples, so isolated load transients do not move it.
+ *
+ * Once the estimate differs from the resistance implied by the programmed VM_CNF by more than
+ * STC3115_RINT_THRESHOLD percent, getAdjustment() proposes a new VM_CNF that moves at most
+ * STC3115_RINT_MAX_ADJUSTMENT percent towards it, at most once every STC3115_RINT_ADJUST_INTERVAL conversions.
+ */
+class STC3115RintEstimator {
+public:
+    STC3115RintEstimator();
+
+    void enable();
+    void disable();
+    bool isEnabled();
+    bool update(const STC3115BatteryData& data);
+    bool getAdjustment(int capacity, int vmConf, int* next);
+    void resync();
+    void clear();
+    int getResistance();
+    uint16_t getSampleCount();
+    uint16_t getRejectCount();
+
+    static int toVMConf(int capacity, int resistance);
+    static int fromVMConf(int capacity, int vmConf);
+private:
+    int16_t samples[STC3115_RINT_SAMPLES];
+    uint8_t head;
+    uint8_t count;
+    bool enabled;
+    bool synced;
+    bool adjusted;
+    int lastVoltage;
+    int lastCurrent;
+    int lastCounter;
+    int lastAdjustment;
+    uint16_t accepted;
+    uint16_t rejected;
+};
+
+#endif
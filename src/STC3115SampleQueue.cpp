@@ -0,0 +1,111 @@
+#include "STC3115SampleQueue.h"
+
+/**
+ * @brief Initialize the queue on top of a caller-provided buffer
+ *
+ * @param buffer array of capacity entries
+ * @param capacity number of entries in the buffer; only the first STC3115_SAMPLE_QUEUE_MAX_CAPACITY are used
+ */
+STC3115SampleQueue::STC3115SampleQueue(STC3115BatteryData* buffer, size_t capacity):
+ buffer(buffer),
+ capacity(capacity > STC3115_SAMPLE_QUEUE_MAX_CAPACITY ? STC3115_SAMPLE_QUEUE_MAX_CAPACITY : static_cast<stc3115_seq_t>(capacity)),
+ head(0),
+ tail(0),
+ dropCount(0) {}
+
+/**
+ * @brief Append a sample. Must only be called by the producer.
+ *
+ * @param sample measurement set to be queued
+ * @return true if the sample was queued
+ * @return false if the queue was full and the sample was dropped
+ */
+bool STC3115SampleQueue::push(const STC3115BatteryData& sample) {
+    if (buffer == NULL || capacity < 2) {
+        dropCount = dropCount + 1;
+        return false;
+    }
+
+    stc3115_seq_t current = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    stc3115_seq_t next = current + 1;
+    if (next == capacity) {
+        next = 0;
+    }
+
+    if (next == __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) {
+        dropCount = dropCount + 1;
+        return false;
+    }
+
+    buffer[current] = sample;
+    __atomic_store_n(&head, next, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/**
+ * @brief Take the oldest sample. Must only be called by the consumer.
+ *
+ * @param sample pointer to the structure that will hold the sample
+ * @return true if a sample was taken
+ * @return false if the queue was empty
+ */
+bool STC3115SampleQueue::pop(STC3115BatteryData* sample) {
+    stc3115_seq_t current = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    if (current == __atomic_load_n(&head, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    *sample = buffer[current];
+
+    stc3115_seq_t next = current + 1;
+    if (next == capacity) {
+        next = 0;
+    }
+
+    __atomic_store_n(&tail, next, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/**
+ * @brief Get the number of queued samples
+ *
+ * @return size_t
+ */
+size_t STC3115SampleQueue::size() {
+    stc3115_seq_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    stc3115_seq_t t = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+
+    if (h >= t) {
+        return h - t;
+    }
+
+    return capacity - t + h;
+}
+
+/**
+ * @brief Get the number of buffer entries. The queue holds at most one sample less.
+ *
+ * @return size_t
+ */
+size_t STC3115SampleQueue::getCapacity() {
+    return capacity;
+}
+
+/**
+ * @brief Get the number of samples dropped because the queue was full
+ *
+ * @return uint32_t
+ */
+uint32_t STC3115SampleQueue::getDropCount() {
+    return dropCount;
+}
+
+/**
+ * @brief Clear the drop counter
+ *
+ */
+void STC3115SampleQueue::resetDropCount() {
+    dropCount = 0;
+}
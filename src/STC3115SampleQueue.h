@@ -0,0 +1,39 @@
+#ifndef STC3115_SAMPLE_QUEUE_H
+#define STC3115_SAMPLE_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "STC3115_types.h"
+#include "STC3115SeqLock.h"
+
+#define STC3115_SAMPLE_QUEUE_MAX_CAPACITY static_cast<stc3115_seq_t>(~static_cast<stc3115_seq_t>(0))
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer queue of measurement sets.
+ *
+ * The storage is provided by the caller. One slot is kept free to tell a full queue from an empty one,
+ * so a buffer of N entries holds N - 1 samples. When the queue is full the new sample is dropped and
+ * the drop counter is incremented; samples already queued are never overwritten.
+ *
+ * Indices are stc3115_seq_t so they are updated atomically; on AVR that limits the queue to
+ * STC3115_SAMPLE_QUEUE_MAX_CAPACITY entries of the buffer, and getCapacity() reports the number actually used.
+ */
+class STC3115SampleQueue {
+public:
+    STC3115SampleQueue(STC3115BatteryData* buffer, size_t capacity);
+
+    bool push(const STC3115BatteryData& sample);
+    bool pop(STC3115BatteryData* sample);
+    size_t size();
+    size_t getCapacity();
+    uint32_t getDropCount();
+    void resetDropCount();
+private:
+    STC3115BatteryData* buffer;
+    stc3115_seq_t capacity;
+    stc3115_seq_t head;
+    stc3115_seq_t tail;
+    volatile uint32_t dropCount;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "STC3115Sampler.h"
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+#include <chrono>
+#endif
+
+/**
+ * @brief Initialize the sampler for a gauge
+ *
+ * @param gauge gauge that will be sampled
+ */
+STC3115Sampler::STC3115Sampler(STC3115& gauge):
+ gauge(gauge),
+ queueCount(0),
+ lastCounter(-1),
+ sampleCount(0),
+ periodMs(STC3115_SAMPLER_PERIOD_MS),
+ running(false)
+#if defined(ESP_PLATFORM)
+ , task(NULL)
+#endif
+{
+    for (int i = 0; i < STC3115_SAMPLER_MAX_QUEUES; i++) {
+        queues[i] = NULL;
+    }
+}
+
+STC3115Sampler::~STC3115Sampler() {
+    stop();
+}
+
+/**
+ * @brief Add a consumer queue. Queues must be attached before start().
+ *
+ * @param queue queue that will receive every new measurement set
+ * @return true
+ * @return false if STC3115_SAMPLER_MAX_QUEUES queues are already attached or the sampler is running
+ */
+bool STC3115Sampler::attach(STC3115SampleQueue* queue) {
+    if (queue == NULL || isRunning() || queueCount >= STC3115_SAMPLER_MAX_QUEUES) {
+        return false;
+    }
+
+    queues[queueCount++] = queue;
+    return true;
+}
+
+/**
+ * @brief Start the sampling task.
+ *
+ * @param periodMs delay between two run() calls
+ * @param core core the task is pinned to (ESP32 only)
+ * @return true if the task was started
+ * @return false if it is already running or the platform has no task support
+ */
+bool STC3115Sampler::start(uint32_t periodMs, int core) {
+    if (isRunning()) {
+        return false;
+    }
+
+    this->periodMs = periodMs;
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+
+#if defined(ESP_PLATFORM)
+    TaskHandle_t handle = NULL;
+    if (xTaskCreatePinnedToCore(taskEntry, "stc3115", STC3115_SAMPLER_STACK_SIZE, this, STC3115_SAMPLER_PRIORITY, &handle, core) != pdPASS) {
+        __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    __atomic_store_n(&task, handle, __ATOMIC_RELEASE);
+    return true;
+#elif defined(__linux__)
+    (void) core;
+    thread = std::thread(taskEntry, this);
+    return true;
+#else
+    (void) core;
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    return false;
+#endif
+}
+
+/**
+ * @brief Stop the sampling task and wait until it has left the gauge loop.
+ *
+ */
+void STC3115Sampler::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+
+#if defined(ESP_PLATFORM)
+    while (__atomic_load_n(&task, __ATOMIC_ACQUIRE) != NULL) {
+        vTaskDelay(1);
+    }
+#elif defined(__linux__)
+    if (thread.joinable()) {
+        thread.join();
+    }
+#endif
+}
+
+/**
+ * @brief Check whether the sampling task is running
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115Sampler::isRunning() {
+    return __atomic_load_n(&running, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Run one gauge iteration and queue the result if the conversion counter moved.
+ *
+ * @return true if a new measurement set was queued
+ * @return false otherwise
+ */
+bool STC3115Sampler::poll() {
+    STC3115BatteryData sample;
+
+    gauge.run();
+    if (!gauge.getSnapshot(&sample)) {
+        return false;
+    }
+
+    if (sample.ConvCounter == lastCounter) {
+        return false;
+    }
+
+    lastCounter = sample.ConvCounter;
+    sampleCount++;
+
+    for (uint8_t i = 0; i < queueCount; i++) {
+        queues[i]->push(sample);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get the number of new measurement sets seen by the sampler
+ *
+ * @return uint32_t
+ */
+uint32_t STC3115Sampler::getSampleCount() {
+    return sampleCount;
+}
+
+/**
+ * @brief Body of the sampling task
+ *
+ * @param arg the sampler
+ */
+void STC3115Sampler::taskEntry(void* arg) {
+    STC3115Sampler* sampler = static_cast<STC3115Sampler*>(arg);
+
+    while (__atomic_load_n(&sampler->running, __ATOMIC_ACQUIRE)) {
+        sampler->poll();
+
+#if defined(ESP_PLATFORM)
+        vTaskDelay(pdMS_TO_TICKS(sampler->periodMs));
+#elif defined(__linux__)
+        std::this_thread::sleep_for(std::chrono::milliseconds(sampler->periodMs));
+#endif
+    }
+
+#if defined(ESP_PLATFORM)
+    __atomic_store_n(&sampler->task, static_cast<TaskHandle_t>(NULL), __ATOMIC_RELEASE);
+    vTaskDelete(NULL);
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef STC3115_SAMPLER_H
+#define STC3115_SAMPLER_H
+
+#include "STC3115.h"
+#include "STC3115SampleQueue.h"
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__linux__)
+#include <thread>
+#endif
+
+#ifndef STC3115_SAMPLER_MAX_QUEUES
+#define STC3115_SAMPLER_MAX_QUEUES 4
+#endif
+
+#ifndef STC3115_SAMPLER_PERIOD_MS
+#define STC3115_SAMPLER_PERIOD_MS 250
+#endif
+
+#ifndef STC3115_SAMPLER_STACK_SIZE
+#define STC3115_SAMPLER_STACK_SIZE 4096
+#endif
+
+#ifndef STC3115_SAMPLER_PRIORITY
+#define STC3115_SAMPLER_PRIORITY 5
+#endif
+
+#ifndef STC3115_SAMPLER_CORE
+#define STC3115_SAMPLER_CORE 1
+#endif
+
+/**
+ * @brief Runs the gauge loop and pushes every new measurement set into one or more sample queues.
+ *
+ * Once started, the sampler owns the gauge: the application must not call run() itself.
+ * On ESP32 the loop runs in a FreeRTOS task pinned to one core, on Linux in a std::thread.
+ * On other platforms call poll() from loop().
+ */
+class STC3115Sampler {
+public:
+    STC3115Sampler(STC3115& gauge);
+    virtual ~STC3115Sampler();
+
+    bool attach(STC3115SampleQueue* queue);
+    bool start(uint32_t periodMs = STC3115_SAMPLER_PERIOD_MS, int core = STC3115_SAMPLER_CORE);
+    void stop();
+    bool isRunning();
+    bool poll();
+    uint32_t getSampleCount();
+private:
+    static void taskEntry(void* arg);
+
+    STC3115& gauge;
+    STC3115SampleQueue* queues[STC3115_SAMPLER_MAX_QUEUES];
+    uint8_t queueCount;
+    int lastCounter;
+    uint32_t sampleCount;
+    uint32_t periodMs;
+    bool running;
+#if defined(ESP_PLATFORM)
+    TaskHandle_t task;
+#elif defined(__linux__)
+    std::thread thread;
+#endif
+};
+
+#endif
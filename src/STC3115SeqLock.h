@@ -0,0 +1,111 @@
+#ifndef STC3115_SEQLOCK_H
+#define STC3115_SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVR__)
+typedef uint8_t stc3115_seq_t;
+#else
+typedef uint32_t stc3115_seq_t;
+#endif
+
+/**
+ * @brief Single-writer sequence lock.
+ *
+ * The writer never waits. Readers copy the value and retry if the writer published in the
+ * meantime, so they never block the writer and never observe a mix of two publications.
+ * The object holds no pointers, which also makes it usable inside a shared memory region.
+ * The version is 0 only before the first publication; when the sequence wraps, 0 is skipped.
+ *
+ * @tparam T trivially copyable value type
+ */
+template <typename T>
+class STC3115SeqLock {
+public:
+    STC3115SeqLock(): sequence(0) {
+        memset(&value, 0, sizeof(T));
+    }
+
+    /**
+     * @brief Publish a new value. Must only be called from one task at a time.
+     *
+     * @param data value to be published
+     */
+    void publish(const T& data) {
+        stc3115_seq_t seq = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+
+        __atomic_store_n(&sequence, static_cast<stc3115_seq_t>(seq + 1), __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(&value, &data, sizeof(T));
+
+        stc3115_seq_t next = seq + 2;
+        if (next == 0) {
+            next = 2;
+        }
+
+        __atomic_store_n(&sequence, next, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief Copy the latest value once.
+     *
+     * @param output pointer to the variable that will hold the value
+     * @param version optional pointer that receives the number of publications so far
+     * @return true if the copy is consistent
+     * @return false if the writer was publishing at the same time
+     */
+    bool tryRead(T* output, stc3115_seq_t* version = NULL) const {
+        stc3115_seq_t before = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+        if ((before & 1) != 0) {
+            return false;
+        }
+
+        memcpy(output, &value, sizeof(T));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&sequence, __ATOMIC_RELAXED) != before) {
+            return false;
+        }
+
+        if (version != NULL) {
+            *version = before >> 1;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Copy the latest value, retrying a bounded number of times.
+     *
+     * @param output pointer to the variable that will hold the value
+     * @param version optional pointer that receives the number of publications so far
+     * @param retries maximum number of attempts
+     * @return true if a consistent copy was made
+     * @return false otherwise
+     */
+    bool read(T* output, stc3115_seq_t* version, uint8_t retries) const {
+        for (uint8_t i = 0; i < retries; i++) {
+            if (tryRead(output, version)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Get the number of publications so far, wrapping past 0.
+     *
+     * @return stc3115_seq_t 0 if nothing was published yet
+     */
+    stc3115_seq_t getVersion() const {
+        return __atomic_load_n(&sequence, __ATOMIC_ACQUIRE) >> 1;
+    }
+
+private:
+    stc3115_seq_t sequence;
+    T value;
+};
+
+#endif
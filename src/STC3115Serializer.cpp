@@ -0,0 +1,371 @@
+#include "STC3115Serializer.h"
+
+#define STC3115_STATUS_PRESENCE    0x01
+#define STC3115_STATUS_VMODE       0x02
+#define STC3115_STATUS_GG_RUN      0x04
+#define STC3115_STATUS_BATFAIL     0x08
+#define STC3115_STATUS_PORDET      0x10
+#define STC3115_STATUS_ALM_SOC     0x20
+#define STC3115_STATUS_ALM_VOLT    0x40
+#define STC3115_STATUS_PROVISIONAL 0x80
+
+/**
+ * @brief Get the size of a binary frame
+ *
+ * @param count number of samples
+ * @return size_t
+ */
+size_t STC3115Serializer::getSerializedSize(size_t count) {
+    return STC3115_SERIAL_HEADER_SIZE + count * STC3115_SERIAL_RECORD_SIZE;
+}
+
+/**
+ * @brief Encode one measurement set as a binary frame
+ *
+ * @param sample measurement set
+ * @param buffer output buffer
+ * @param size size of the output buffer
+ * @return size_t number of bytes written, 0 if the buffer is too small
+ */
+size_t STC3115Serializer::serialize(const STC3115BatteryData& sample, uint8_t* buffer, size_t size) {
+    return serializeBatch(&sample, 1, buffer, size);
+}
+
+/**
+ * @brief Encode several measurement sets as one binary frame
+ *
+ * @param samples measurement sets
+ * @param count number of measurement sets, at most STC3115_SERIAL_MAX_SAMPLES
+ * @param buffer output buffer
+ * @param size size of the output buffer
+ * @return size_t number of bytes written, 0 if the buffer is too small
+ */
+size_t STC3115Serializer::serializeBatch(const STC3115BatteryData* samples, size_t count, uint8_t* buffer, size_t size) {
+    if (count > STC3115_SERIAL_MAX_SAMPLES || size < getSerializedSize(count)) {
+        return 0;
+    }
+
+    buffer[0] = STC3115_SERIAL_VERSION;
+    buffer[1] = count;
+
+    for (size_t i = 0; i < count; i++) {
+        writeRecord(samples[i], &buffer[STC3115_SERIAL_HEADER_SIZE + i * STC3115_SERIAL_RECORD_SIZE]);
+    }
+
+    return getSerializedSize(count);
+}
+
+/**
+ * @brief Drain queued measurement sets into one binary frame, as many as the buffer can hold.
+ *
+ * @param queue queue of measurement sets, consumed by this call
+ * @param buffer output buffer
+ * @param size size of the output buffer
+ * @return size_t number of bytes written, 0 if the buffer cannot hold the header and one sample
+ */
+size_t STC3115Serializer::serializeBatch(STC3115SampleQueue& queue, uint8_t* buffer, size_t size) {
+    if (size < getSerializedSize(1)) {
+        return 0;
+    }
+
+    size_t capacity = (size - STC3115_SERIAL_HEADER_SIZE) / STC3115_SERIAL_RECORD_SIZE;
+    if (capacity > STC3115_SERIAL_MAX_SAMPLES) {
+        capacity = STC3115_SERIAL_MAX_SAMPLES;
+    }
+
+    size_t count = 0;
+    STC3115BatteryData sample;
+    while (count < capacity && queue.pop(&sample)) {
+        writeRecord(sample, &buffer[STC3115_SERIAL_HEADER_SIZE + count * STC3115_SERIAL_RECORD_SIZE]);
+        count++;
+    }
+
+    buffer[0] = STC3115_SERIAL_VERSION;
+    buffer[1] = count;
+
+    return getSerializedSize(count);
+}
+
+/**
+ * @brief Encode one measurement set as a CBOR array
+ *
+ * @param sample measurement set
+ * @param buffer output buffer, STC3115_CBOR_MAX_SIZE bytes are always enough
+ * @param size size of the output buffer
+ * @return size_t number of bytes written, 0 if the buffer is too small
+ */
+size_t STC3115Serializer::serializeCBOR(const STC3115BatteryData& sample, uint8_t* buffer, size_t size) {
+    long fields[STC3115_CBOR_FIELD_COUNT] = {
+        STC3115_SERIAL_VERSION, sample.SOC, sample.Voltage, sample.Current, sample.Temperature,
+        sample.OCV, sample.ConvCounter, sample.RemTime, sample.ChargeValue, encodeStatus(sample)
+    };
+
+    if (size < 1) {
+        return 0;
+    }
+
+    buffer[0] = 0x80 | STC3115_CBOR_FIELD_COUNT;
+    size_t length = 1;
+
+    for (int i = 0; i < STC3115_CBOR_FIELD_COUNT; i++) {
+        size_t written = writeCBORInteger(fields[i], &buffer[length], size - length);
+        if (written == 0) {
+            return 0;
+        }
+
+        length += written;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Decode a binary frame
+ *
+ * @param buffer received frame
+ * @param size size of the frame
+ * @param samples array that will hold the measurement sets
+ * @param maxSamples number of entries in the array
+ * @return size_t number of decoded measurement sets, 0 if the frame is invalid or has an unknown version
+ */
+size_t STC3115Serializer::deserialize(const uint8_t* buffer, size_t size, STC3115BatteryData* samples, size_t maxSamples) {
+    if (size < STC3115_SERIAL_HEADER_SIZE || buffer[0] != STC3115_SERIAL_VERSION) {
+        return 0;
+    }
+
+    size_t count = buffer[1];
+    if (size < getSerializedSize(count)) {
+        return 0;
+    }
+
+    if (count > maxSamples) {
+        count = maxSamples;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        readRecord(&buffer[STC3115_SERIAL_HEADER_SIZE + i * STC3115_SERIAL_RECORD_SIZE], &samples[i]);
+    }
+
+    return count;
+}
+
+/**
+ * @brief Decode a CBOR array written by serializeCBOR()
+ *
+ * @param buffer received data
+ * @param size size of the data
+ * @param sample pointer to the structure that will hold the measurement set
+ * @return true
+ * @return false if the data is invalid or has an unknown version
+ */
+bool STC3115Serializer::deserializeCBOR(const uint8_t* buffer, size_t size, STC3115BatteryData* sample) {
+    long fields[STC3115_CBOR_FIELD_COUNT];
+
+    if (size < 1 || buffer[0] != (0x80 | STC3115_CBOR_FIELD_COUNT)) {
+        return false;
+    }
+
+    size_t offset = 1;
+    for (int i = 0; i < STC3115_CBOR_FIELD_COUNT; i++) {
+        size_t read = readCBORInteger(&buffer[offset], size - offset, &fields[i]);
+        if (read == 0) {
+            return false;
+        }
+
+        offset += read;
+    }
+
+    if (fields[0] != STC3115_SERIAL_VERSION) {
+        return false;
+    }
+
+    sample->SOC = fields[1];
+    sample->HRSOC = (fields[1] * 512 + 5) / 10;
+    sample->Voltage = fields[2];
+    sample->Current = fields[3];
+    sample->Temperature = fields[4];
+    sample->OCV = fields[5];
+    sample->ConvCounter = fields[6];
+    sample->RemTime = fields[7];
+    sample->ChargeValue = fields[8];
+    decodeStatus(fields[9], sample);
+
+    return true;
+}
+
+void STC3115Serializer::writeRecord(const STC3115BatteryData& sample, uint8_t* record) {
+    uint16_t soc = clamp(sample.SOC, 0, 0xffff);
+    uint16_t voltage = clamp(sample.Voltage, 0, 0xffff);
+    int16_t current = clamp(sample.Current, -32768, 32767);
+    int8_t temperature = clamp(sample.Temperature / 10, -128, 127);
+    uint16_t ocv = clamp(sample.OCV, 0, 0xffff);
+    uint16_t counter = sample.ConvCounter & 0xffff;
+    int16_t remaining = clamp(sample.RemTime, -32768, 32767);
+    uint16_t charge = clamp(sample.ChargeValue, 0, 0xffff);
+
+    record[0] = soc & 0xff;
+    record[1] = soc >> 8;
+    record[2] = voltage & 0xff;
+    record[3] = voltage >> 8;
+    record[4] = static_cast<uint16_t>(current) & 0xff;
+    record[5] = static_cast<uint16_t>(current) >> 8;
+    record[6] = static_cast<uint8_t>(temperature);
+    record[7] = ocv & 0xff;
+    record[8] = ocv >> 8;
+    record[9] = counter & 0xff;
+    record[10] = counter >> 8;
+    record[11] = static_cast<uint16_t>(remaining) & 0xff;
+    record[12] = static_cast<uint16_t>(remaining) >> 8;
+    record[13] = charge & 0xff;
+    record[14] = charge >> 8;
+    record[15] = encodeStatus(sample);
+}
+
+void STC3115Serializer::readRecord(const uint8_t* record, STC3115BatteryData* sample) {
+    sample->SOC = record[0] | (record[1] << 8);
+    sample->HRSOC = (sample->SOC * 512 + 5) / 10;
+    sample->Voltage = record[2] | (record[3] << 8);
+    sample->Current = static_cast<int16_t>(record[4] | (record[5] << 8));
+    sample->Temperature = static_cast<int8_t>(record[6]) * 10;
+    sample->OCV = record[7] | (record[8] << 8);
+    sample->ConvCounter = record[9] | (record[10] << 8);
+    sample->RemTime = static_cast<int16_t>(record[11] | (record[12] << 8));
+    sample->ChargeValue = record[13] | (record[14] << 8);
+    decodeStatus(record[15], sample);
+}
+
+uint8_t STC3115Serializer::encodeStatus(const STC3115BatteryData& sample) {
+    int ctrl = sample.StatusWord >> 8;
+    uint8_t status = 0;
+
+    status |= sample.Presence == 1 ? STC3115_STATUS_PRESENCE : 0;
+    status |= (sample.StatusWord & STC3115_VMODE) != 0 ? STC3115_STATUS_VMODE : 0;
+    status |= (sample.StatusWord & STC3115_GG_RUN) != 0 ? STC3115_STATUS_GG_RUN : 0;
+    status |= (ctrl & STC3115_BATFAIL) != 0 ? STC3115_STATUS_BATFAIL : 0;
+    status |= (ctrl & STC3115_PORDET) != 0 ? STC3115_STATUS_PORDET : 0;
+    status |= (ctrl & STC3115_ALM_SOC) != 0 ? STC3115_STATUS_ALM_SOC : 0;
+    status |= (ctrl & STC3115_ALM_VOLT) != 0 ? STC3115_STATUS_ALM_VOLT : 0;
+    status |= sample.Provisional != 0 ? STC3115_STATUS_PROVISIONAL : 0;
+
+    return status;
+}
+
+void STC3115Serializer::decodeStatus(uint8_t status, STC3115BatteryData* sample) {
+    int ctrl = 0;
+    int mode = 0;
+
+    mode |= (status & STC3115_STATUS_VMODE) != 0 ? STC3115_VMODE : 0;
+    mode |= (status & STC3115_STATUS_GG_RUN) != 0 ? STC3115_GG_RUN : 0;
+    ctrl |= (status & STC3115_STATUS_BATFAIL) != 0 ? STC3115_BATFAIL : 0;
+    ctrl |= (status & STC3115_STATUS_PORDET) != 0 ? STC3115_PORDET : 0;
+    ctrl |= (status & STC3115_STATUS_ALM_SOC) != 0 ? STC3115_ALM_SOC : 0;
+    ctrl |= (status & STC3115_STATUS_ALM_VOLT) != 0 ? STC3115_ALM_VOLT : 0;
+
+    sample->StatusWord = mode | (ctrl << 8);
+    sample->Presence = (status & STC3115_STATUS_PRESENCE) != 0 ? 1 : 0;
+    sample->Provisional = (status & STC3115_STATUS_PROVISIONAL) != 0 ? 1 : 0;
+}
+
+/**
+ * @brief Write a CBOR unsigned (major type 0) or negative (major type 1) integer
+ *
+ * @return size_t number of bytes written, 0 if the buffer is too small
+ */
+size_t STC3115Serializer::writeCBORInteger(long value, uint8_t* buffer, size_t size) {
+    uint8_t major = 0x00;
+    uint32_t argument = value;
+    if (value < 0) {
+        major = 0x20;
+        argument = static_cast<uint32_t>(-1 - value);
+    }
+
+    size_t length;
+    if (argument < 24) {
+        length = 1;
+    } else if (argument <= 0xff) {
+        length = 2;
+    } else if (argument <= 0xffff) {
+        length = 3;
+    } else {
+        length = 5;
+    }
+
+    if (size < length) {
+        return 0;
+    }
+
+    switch (length) {
+    case 1:
+        buffer[0] = major | argument;
+        break;
+    case 2:
+        buffer[0] = major | 24;
+        buffer[1] = argument;
+        break;
+    case 3:
+        buffer[0] = major | 25;
+        buffer[1] = argument >> 8;
+        buffer[2] = argument & 0xff;
+        break;
+    default:
+        buffer[0] = major | 26;
+        buffer[1] = argument >> 24;
+        buffer[2] = (argument >> 16) & 0xff;
+        buffer[3] = (argument >> 8) & 0xff;
+        buffer[4] = argument & 0xff;
+        break;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Read a CBOR integer of at most 32 bits
+ *
+ * @return size_t number of bytes read, 0 if the data is not such an integer
+ */
+size_t STC3115Serializer::readCBORInteger(const uint8_t* buffer, size_t size, long* value) {
+    if (size < 1) {
+        return 0;
+    }
+
+    uint8_t major = buffer[0] & 0xe0;
+    uint8_t info = buffer[0] & 0x1f;
+    if (major != 0x00 && major != 0x20) {
+        return 0;
+    }
+
+    uint32_t argument;
+    size_t length;
+    if (info < 24) {
+        argument = info;
+        length = 1;
+    } else if (info == 24 && size >= 2) {
+        argument = buffer[1];
+        length = 2;
+    } else if (info == 25 && size >= 3) {
+        argument = (static_cast<uint32_t>(buffer[1]) << 8) | buffer[2];
+        length = 3;
+    } else if (info == 26 && size >= 5) {
+        argument = (static_cast<uint32_t>(buffer[1]) << 24) | (static_cast<uint32_t>(buffer[2]) << 16) |
+                   (static_cast<uint32_t>(buffer[3]) << 8) | buffer[4];
+        length = 5;
+    } else {
+        return 0;
+    }
+
+    *value = major == 0x20 ? -1 - static_cast<long>(argument) : static_cast<long>(argument);
+    return length;
+}
+
+long STC3115Serializer::clamp(long value, long minimum, long maximum) {
+    if (value < minimum) {
+        return minimum;
+    }
+
+    if (value > maximum) {
+        return maximum;
+    }
+
+    return value;
+}
@@ -0,0 +1,52 @@
+#ifndef STC3115_SERIALIZER_H
+#define STC3115_SERIALIZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "STC3115_types.h"
+#include "STC3115SampleQueue.h"
+
+#define STC3115_SERIAL_VERSION      1
+#define STC3115_SERIAL_HEADER_SIZE  2
+#define STC3115_SERIAL_RECORD_SIZE  16
+#define STC3115_SERIAL_MAX_SAMPLES  255
+#define STC3115_CBOR_FIELD_COUNT    10
+#define STC3115_CBOR_MAX_SIZE       (1 + STC3115_CBOR_FIELD_COUNT * 5)
+
+/**
+ * @brief Compact, versioned encoding of measurement sets for constrained uplinks.
+ *
+ * Binary frame, little endian:
+ *   header: version (1 byte), sample count (1 byte)
+ *   record: SOC 0.1% (u16), voltage mV (u16), current mA (i16), temperature degree (i8), OCV mV (u16),
+ *           conversion counter (u16), remaining time min (i16), remaining charge mAh (u16), status flags (u8)
+ *   status flags: presence 0x01, VMODE 0x02, GG_RUN 0x04, BATFAIL 0x08, PORDET 0x10, ALM_SOC 0x20, ALM_VOLT 0x40,
+ *                 provisional estimate 0x80
+ *
+ * The CBOR encoding is a definite array of STC3115_CBOR_FIELD_COUNT integers: version followed by the record
+ * fields in the same order, with temperature in 0.1 degree.
+ *
+ * Encoders write straight into the caller buffer, never allocate, and return 0 if the buffer is too small.
+ */
+class STC3115Serializer {
+public:
+    static size_t getSerializedSize(size_t count);
+
+    static size_t serialize(const STC3115BatteryData& sample, uint8_t* buffer, size_t size);
+    static size_t serializeBatch(const STC3115BatteryData* samples, size_t count, uint8_t* buffer, size_t size);
+    static size_t serializeBatch(STC3115SampleQueue& queue, uint8_t* buffer, size_t size);
+    static size_t serializeCBOR(const STC3115BatteryData& sample, uint8_t* buffer, size_t size);
+
+    static size_t deserialize(const uint8_t* buffer, size_t size, STC3115BatteryData* samples, size_t maxSamples);
+    static bool deserializeCBOR(const uint8_t* buffer, size_t size, STC3115BatteryData* sample);
+private:
+    static void writeRecord(const STC3115BatteryData& sample, uint8_t* record);
+    static void readRecord(const uint8_t* record, STC3115BatteryData* sample);
+    static uint8_t encodeStatus(const STC3115BatteryData& sample);
+    static void decodeStatus(uint8_t status, STC3115BatteryData* sample);
+    static size_t writeCBORInteger(long value, uint8_t* buffer, size_t size);
+    static size_t readCBORInteger(const uint8_t* buffer, size_t size, long* value);
+    static long clamp(long value, long minimum, long maximum);
+};
+
+#endif
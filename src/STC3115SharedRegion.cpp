@@ -0,0 +1,267 @@
+#include "STC3115SharedRegion.h"
+
+#if !defined(ARDUINO)
+
+#include <new>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+STC3115SharedRegion::STC3115SharedRegion():
+ layout(NULL),
+ owner(false) {
+    name[0] = '\0';
+}
+
+STC3115SharedRegion::~STC3115SharedRegion() {
+    close();
+}
+
+/**
+ * @brief Create or take over the shared region as its writer. Slots are added with addGauge(), then markReady().
+ *
+ * An existing region of the same name is reused, so consumers that still have it mapped see the new slots
+ * once markReady() is called.
+ *
+ * @param name POSIX shared memory object name, starting with a slash
+ * @return true
+ * @return false
+ */
+bool STC3115SharedRegion::create(const char* name) {
+    close();
+
+    int fd = shm_open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (ftruncate(fd, sizeof(STC3115SharedLayout)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* address = mmap(NULL, sizeof(STC3115SharedLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+
+    layout = static_cast<STC3115SharedLayout*>(address);
+    __atomic_store_n(&layout->Magic, 0, __ATOMIC_RELEASE);
+
+    layout->Version = STC3115_SHARED_VERSION;
+    layout->GaugeCount = 0;
+    layout->Size = sizeof(STC3115SharedLayout);
+    layout->Reserved = 0;
+    for (int i = 0; i < STC3115_SHARED_MAX_GAUGES; i++) {
+        memset(layout->Gauges[i].Bus, 0, STC3115_SHARED_BUS_LENGTH);
+        memset(layout->Gauges[i].Reserved, 0, sizeof(layout->Gauges[i].Reserved));
+        layout->Gauges[i].Address = 0;
+        new (&layout->Gauges[i].Sample) STC3115SeqLock<STC3115SharedSample>();
+    }
+
+    strncpy(this->name, name, STC3115_SHARED_BUS_LENGTH - 1);
+    this->name[STC3115_SHARED_BUS_LENGTH - 1] = '\0';
+    owner = true;
+
+    return true;
+}
+
+/**
+ * @brief Map the region published by a running writer, read-only.
+ *
+ * @param name POSIX shared memory object name, starting with a slash
+ * @return true
+ * @return false if the region does not exist, is not ready yet, or was created by an incompatible version
+ */
+bool STC3115SharedRegion::open(const char* name) {
+    close();
+
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(STC3115SharedLayout)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* address = mmap(NULL, sizeof(STC3115SharedLayout), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+
+    layout = static_cast<STC3115SharedLayout*>(address);
+    if (__atomic_load_n(&layout->Magic, __ATOMIC_ACQUIRE) != STC3115_SHARED_MAGIC ||
+        layout->Version != STC3115_SHARED_VERSION || layout->Size != sizeof(STC3115SharedLayout)) {
+        close();
+        return false;
+    }
+
+    owner = false;
+    return true;
+}
+
+/**
+ * @brief Unmap the region. The writer also removes the name, so new consumers cannot open a stale region.
+ *
+ */
+void STC3115SharedRegion::close() {
+    if (layout == NULL) {
+        return;
+    }
+
+    if (owner) {
+        __atomic_store_n(&layout->Magic, 0, __ATOMIC_RELEASE);
+        shm_unlink(name);
+    }
+
+    munmap(layout, sizeof(STC3115SharedLayout));
+    layout = NULL;
+    owner = false;
+}
+
+/**
+ * @brief Check whether a region is mapped
+ *
+ * @return true
+ * @return false
+ */
+bool STC3115SharedRegion::isOpen() {
+    return layout != NULL;
+}
+
+/**
+ * @brief Reserve the slot of a gauge. Writer only, before markReady().
+ *
+ * @param bus name of the bus the gauge is on, e.g. /dev/i2c-1
+ * @param address I2C address of the gauge
+ * @return int slot index, or -1 if the region is full or not writable
+ */
+int STC3115SharedRegion::addGauge(const char* bus, uint8_t address) {
+    if (layout == NULL || !owner || layout->GaugeCount >= STC3115_SHARED_MAX_GAUGES) {
+        return -1;
+    }
+
+    int index = layout->GaugeCount;
+    strncpy(layout->Gauges[index].Bus, bus, STC3115_SHARED_BUS_LENGTH - 1);
+    layout->Gauges[index].Address = address;
+    layout->GaugeCount++;
+
+    return index;
+}
+
+/**
+ * @brief Make the slots visible to consumers. Writer only.
+ *
+ */
+void STC3115SharedRegion::markReady() {
+    if (layout == NULL || !owner) {
+        return;
+    }
+
+    __atomic_store_n(&layout->Magic, STC3115_SHARED_MAGIC, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publish a measurement set to the slot of a gauge. Must only be called by the thread that owns the gauge.
+ *
+ * @param index slot index returned by addGauge()
+ * @param data measurement set
+ * @param timestamp publication time in milliseconds
+ * @return true
+ * @return false
+ */
+bool STC3115SharedRegion::publish(int index, const STC3115BatteryData& data, uint64_t timestamp) {
+    if (layout == NULL || !owner || index < 0 || index >= layout->GaugeCount) {
+        return false;
+    }
+
+    STC3115SharedSample sample;
+    sample.StatusWord = data.StatusWord;
+    sample.HRSOC = data.HRSOC;
+    sample.SOC = data.SOC;
+    sample.Voltage = data.Voltage;
+    sample.Current = data.Current;
+    sample.Temperature = data.Temperature;
+    sample.ConvCounter = data.ConvCounter;
+    sample.OCV = data.OCV;
+    sample.Presence = data.Presence;
+    sample.ChargeValue = data.ChargeValue;
+    sample.RemTime = data.RemTime;
+    sample.Flags = data.Provisional != 0 ? STC3115_SHARED_FLAG_PROVISIONAL : 0;
+    sample.Timestamp = timestamp;
+
+    layout->Gauges[index].Sample.publish(sample);
+    return true;
+}
+
+/**
+ * @brief Get the number of gauge slots
+ *
+ * @return int
+ */
+int STC3115SharedRegion::getGaugeCount() {
+    if (layout == NULL || __atomic_load_n(&layout->Magic, __ATOMIC_ACQUIRE) != STC3115_SHARED_MAGIC) {
+        return 0;
+    }
+
+    return layout->GaugeCount;
+}
+
+/**
+ * @brief Get the bus and address of a slot
+ *
+ * @param index slot index
+ * @param bus pointer that receives the bus name, valid while the region is mapped
+ * @param address pointer that receives the I2C address
+ * @return true
+ * @return false
+ */
+bool STC3115SharedRegion::getGauge(int index, const char** bus, uint8_t* address) {
+    if (index < 0 || index >= getGaugeCount()) {
+        return false;
+    }
+
+    *bus = layout->Gauges[index].Bus;
+    *address = layout->Gauges[index].Address;
+    return true;
+}
+
+/**
+ * @brief Copy the latest sample of a slot
+ *
+ * @param index slot index
+ * @param output pointer to the structure that will hold the sample
+ * @param version optional pointer that receives the number of samples published to the slot
+ * @return true if a consistent copy was made
+ * @return false otherwise
+ */
+bool STC3115SharedRegion::read(int index, STC3115SharedSample* output, stc3115_seq_t* version) {
+    if (index < 0 || index >= getGaugeCount()) {
+        return false;
+    }
+
+    return layout->Gauges[index].Sample.read(output, version, STC3115_SNAPSHOT_RETRIES);
+}
+
+/**
+ * @brief Get the number of samples published to a slot. Consumers can poll it to detect new samples.
+ *
+ * @param index slot index
+ * @return stc3115_seq_t
+ */
+stc3115_seq_t STC3115SharedRegion::getVersion(int index) {
+    if (index < 0 || index >= getGaugeCount()) {
+        return 0;
+    }
+
+    return layout->Gauges[index].Sample.getVersion();
+}
+
+#endif
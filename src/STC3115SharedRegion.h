@@ -0,0 +1,106 @@
+#ifndef STC3115_SHARED_REGION_H
+#define STC3115_SHARED_REGION_H
+
+#if !defined(ARDUINO)
+
+#include <stdint.h>
+#include <stddef.h>
+#include "STC3115_types.h"
+#include "STC3115SeqLock.h"
+
+#define STC3115_SHARED_MAGIC 0x35313153
+#define STC3115_SHARED_VERSION 1
+
+#ifndef STC3115_SHARED_NAME
+#define STC3115_SHARED_NAME "/stc3115"
+#endif
+
+#ifndef STC3115_SHARED_MAX_GAUGES
+#define STC3115_SHARED_MAX_GAUGES 16
+#endif
+
+#define STC3115_SHARED_BUS_LENGTH 32
+
+#define STC3115_SHARED_FLAG_PROVISIONAL 0x01
+
+/**
+ * @brief Measurement set as stored in the shared region.
+ *
+ * Fixed-width fields, so processes built with another driver profile agree on the layout. Timestamp is the
+ * CLOCK_MONOTONIC time of the publication in milliseconds. Flags is a combination of STC3115_SHARED_FLAG_*.
+ */
+typedef struct {
+    int32_t StatusWord;
+    int32_t HRSOC;
+    int32_t SOC;
+    int32_t Voltage;
+    int32_t Current;
+    int32_t Temperature;
+    int32_t ConvCounter;
+    int32_t OCV;
+    int32_t Presence;
+    int32_t ChargeValue;
+    int32_t RemTime;
+    uint32_t Flags;
+    uint64_t Timestamp;
+} STC3115SharedSample;
+
+/**
+ * @brief Slot of one gauge. Bus and Address are written once before the region is marked valid.
+ *
+ */
+typedef struct {
+    char Bus[STC3115_SHARED_BUS_LENGTH];
+    uint8_t Address;
+    uint8_t Reserved[7];
+    STC3115SeqLock<STC3115SharedSample> Sample;
+} STC3115SharedGauge;
+
+/**
+ * @brief Layout of the shared memory region published by the polling daemon (extras/linux/stc3115d.cpp).
+ *
+ * Magic is stored last with release ordering once every slot is initialized; readers check Magic, Version and
+ * Size before using the slots.
+ */
+typedef struct {
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t GaugeCount;
+    uint32_t Size;
+    uint32_t Reserved;
+    STC3115SharedGauge Gauges[STC3115_SHARED_MAX_GAUGES];
+} STC3115SharedLayout;
+
+/**
+ * @brief Maps the shared region, as its single writer (create) or as a read-only consumer (open).
+ *
+ * Readers copy samples through the per-gauge sequence lock: no system call and no lock is involved, and a
+ * reader can never stall the daemon.
+ */
+class STC3115SharedRegion {
+public:
+    STC3115SharedRegion();
+    ~STC3115SharedRegion();
+
+    bool create(const char* name = STC3115_SHARED_NAME);
+    bool open(const char* name = STC3115_SHARED_NAME);
+    void close();
+    bool isOpen();
+
+    int addGauge(const char* bus, uint8_t address);
+    void markReady();
+    bool publish(int index, const STC3115BatteryData& data, uint64_t timestamp);
+
+    int getGaugeCount();
+    bool getGauge(int index, const char** bus, uint8_t* address);
+    bool read(int index, STC3115SharedSample* output, stc3115_seq_t* version = NULL);
+    stc3115_seq_t getVersion(int index);
+private:
+    STC3115SharedLayout* layout;
+    char name[STC3115_SHARED_BUS_LENGTH];
+    bool owner;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,345 @@
+#include "STC3115SimulatedI2CBus.h"
+
+#if !defined(ARDUINO)
+
+#include <string.h>
+#include "STC3115_registers.h"
+
+STC3115SimulatedI2CBus::STC3115SimulatedI2CBus():
+ deviceCount(0),
+ transferCount(0) {}
+
+STC3115SimulatedI2CBus::~STC3115SimulatedI2CBus() {}
+
+/**
+ * @brief Add a simulated gauge in power-on state with a 3.8 V idle battery at 25 degrees.
+ *
+ * @param address I2C address of the gauge
+ * @param capacity simulated battery capacity in mAh
+ * @param rSense simulated sense resistor in mOhm
+ * @return true
+ * @return false if the address is taken or STC3115_SIMULATED_MAX_DEVICES devices exist
+ */
+bool STC3115SimulatedI2CBus::addDevice(uint8_t address, int capacity, int rSense) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (deviceCount >= STC3115_SIMULATED_MAX_DEVICES || find(address) != NULL) {
+        return false;
+    }
+
+    Device* device = &devices[deviceCount++];
+    device->address = address;
+    device->capacity = capacity > 0 ? capacity : 1;
+    device->rSense = rSense > 0 ? rSense : 10;
+    device->voltage = 3800;
+    device->current = 0;
+    device->temperature = 25;
+    device->present = true;
+    reset(device);
+
+    return true;
+}
+
+/**
+ * @brief Set the battery the simulated gauge measures
+ *
+ * @param address I2C address of the gauge
+ * @param voltage battery voltage in mV
+ * @param current battery current in mA, positive while charging
+ * @param temperature temperature in degrees Celsius
+ * @return true
+ * @return false if there is no device at the address
+ */
+bool STC3115SimulatedI2CBus::setBattery(uint8_t address, int voltage, int current, int temperature) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    Device* device = find(address);
+    if (device == NULL) {
+        return false;
+    }
+
+    device->voltage = voltage;
+    device->current = current;
+    device->temperature = temperature;
+
+    return true;
+}
+
+/**
+ * @brief Connect or disconnect the simulated battery. A disconnected battery raises BATFAIL.
+ *
+ * @param address I2C address of the gauge
+ * @param present whether the battery is connected
+ * @return true
+ * @return false if there is no device at the address
+ */
+bool STC3115SimulatedI2CBus::setPresent(uint8_t address, bool present) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    Device* device = find(address);
+    if (device == NULL) {
+        return false;
+    }
+
+    device->present = present;
+    if (!present) {
+        device->registers[STC3115_REG_CTRL] |= STC3115_BATFAIL;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Simulate a power cycle of the gauge
+ *
+ * @param address I2C address of the gauge
+ * @return true
+ * @return false if there is no device at the address
+ */
+bool STC3115SimulatedI2CBus::powerOnReset(uint8_t address) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    Device* device = find(address);
+    if (device == NULL) {
+        return false;
+    }
+
+    reset(device);
+    return true;
+}
+
+/**
+ * @brief Copy the register map of a simulated gauge
+ *
+ * @param address I2C address of the gauge
+ * @param output array of STC3115_REGISTER_MAP_SIZE bytes
+ * @return true
+ * @return false if there is no device at the address
+ */
+bool STC3115SimulatedI2CBus::getRegisters(uint8_t address, uint8_t* output) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    Device* device = find(address);
+    if (device == NULL) {
+        return false;
+    }
+
+    memcpy(output, device->registers, STC3115_REGISTER_MAP_SIZE);
+    return true;
+}
+
+/**
+ * @brief Run one conversion cycle on every running gauge
+ *
+ */
+void STC3115SimulatedI2CBus::step() {
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (size_t i = 0; i < deviceCount; i++) {
+        Device* device = &devices[i];
+        if ((device->registers[STC3115_REG_MODE] & STC3115_GG_RUN) == 0) {
+            continue;
+        }
+
+        bool voltageMode = (device->registers[STC3115_REG_MODE] & STC3115_VMODE) != 0;
+        if (!voltageMode) {
+            long long unit = static_cast<long long>(device->capacity) * 3600000LL / MAX_HRSOC;
+            device->charge += static_cast<long long>(device->current) * STC3115_CONV_PERIOD_MIXED_MS;
+
+            long long delta = device->charge / unit;
+            device->charge -= delta * unit;
+            device->hrsoc += static_cast<int>(delta);
+        } else {
+            device->hrsoc = socFromOCV(device->voltage);
+        }
+
+        if (device->hrsoc < 0) {
+            device->hrsoc = 0;
+        } else if (device->hrsoc > MAX_HRSOC) {
+            device->hrsoc = MAX_HRSOC;
+        }
+
+        setWord(device, STC3115_REG_COUNTER_L, (getWord(device, STC3115_REG_COUNTER_L) + 1) & 0xffff);
+        updateMeasurements(device);
+    }
+}
+
+/**
+ * @brief Get the number of transfers processed so far
+ *
+ * @return uint32_t
+ */
+uint32_t STC3115SimulatedI2CBus::getTransferCount() {
+    std::lock_guard<std::mutex> guard(lock);
+    return transferCount;
+}
+
+/**
+ * @brief Process a combined transfer. A message to an unknown address fails the whole transfer, like a NACK.
+ *
+ * @param messages messages to be transferred
+ * @param count number of messages
+ * @return true
+ * @return false
+ */
+bool STC3115SimulatedI2CBus::transfer(struct i2c_msg* messages, size_t count) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (count == 0 || count > maxMessages) {
+        return false;
+    }
+
+    transferCount++;
+
+    for (size_t i = 0; i < count; i++) {
+        struct i2c_msg* message = &messages[i];
+        Device* device = find(message->addr);
+        if (device == NULL) {
+            return false;
+        }
+
+        if ((message->flags & I2C_M_RD) != 0) {
+            for (size_t j = 0; j < message->len; j++) {
+                message->buf[j] = device->pointer < STC3115_REGISTER_MAP_SIZE ? device->registers[device->pointer] : 0;
+                device->pointer++;
+            }
+        } else if (message->len > 0) {
+            device->pointer = message->buf[0];
+            for (size_t j = 1; j < message->len; j++) {
+                writeByte(device, device->pointer, message->buf[j]);
+                device->pointer++;
+            }
+
+            if (message->len == 3 && message->buf[0] == STC3115_REG_SOC_L) {
+                device->hrsoc = getWord(device, STC3115_REG_SOC_L);
+                device->charge = 0;
+            } else if (message->len == 3 && message->buf[0] == STC3115_REG_OCV_L) {
+                long raw = getWord(device, STC3115_REG_OCV_L) & 0x3fff;
+                int ocv = ((((raw * VoltageFactor) >> 11) + 1) / 2 + 2) / 4;
+                device->hrsoc = socFromOCV(ocv);
+                device->charge = 0;
+                setWord(device, STC3115_REG_SOC_L, device->hrsoc);
+            }
+        }
+    }
+
+    return true;
+}
+
+STC3115SimulatedI2CBus::Device* STC3115SimulatedI2CBus::find(uint8_t address) {
+    for (size_t i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Put a device in its power-on state: gauge stopped, PORDET set and OCV measured.
+ *
+ * @param device simulated gauge
+ */
+void STC3115SimulatedI2CBus::reset(Device* device) {
+    memset(device->registers, 0, STC3115_REGISTER_MAP_SIZE);
+    device->registers[STC3115_REG_MODE] = STC3115_REGMODE_DEFAULT_STANDBY;
+    device->registers[STC3115_REG_CTRL] = STC3115_PORDET | (device->present ? 0 : STC3115_BATFAIL);
+    device->registers[STC3115_REG_ID] = STC3115_ID;
+    device->pointer = 0;
+    device->charge = 0;
+    device->hrsoc = socFromOCV(device->voltage);
+
+    setWord(device, STC3115_REG_OCV_L, (device->voltage * 4 * 4096 + VoltageFactor / 2) / VoltageFactor);
+    updateMeasurements(device);
+}
+
+/**
+ * @brief Write a register and apply the side effects of MODE and CTRL writes
+ *
+ * @param device simulated gauge
+ * @param reg register address
+ * @param value written value
+ */
+void STC3115SimulatedI2CBus::writeByte(Device* device, uint8_t reg, uint8_t value) {
+    if (reg >= STC3115_REGISTER_MAP_SIZE || reg == STC3115_REG_ID) {
+        return;
+    }
+
+    if (reg == STC3115_REG_CTRL) {
+        if ((value & STC3115_PORDET) != 0) {
+            reset(device);
+            return;
+        }
+
+        if ((value & STC3115_GG_RST) != 0) {
+            setWord(device, STC3115_REG_COUNTER_L, 0);
+        }
+
+        device->registers[STC3115_REG_CTRL] = (value & 0x01) | (device->present ? 0 : STC3115_BATFAIL);
+        return;
+    }
+
+    if (reg == STC3115_REG_MODE) {
+        bool wasRunning = (device->registers[STC3115_REG_MODE] & STC3115_GG_RUN) != 0;
+        if (!wasRunning && (value & STC3115_GG_RUN) != 0) {
+            setWord(device, STC3115_REG_COUNTER_L, 0);
+        }
+
+        device->registers[STC3115_REG_MODE] = value & ~(STC3115_CLR_VM_ADJ | STC3115_CLR_CC_ADJ);
+        return;
+    }
+
+    device->registers[reg] = value;
+}
+
+/**
+ * @brief Encode the simulated battery into the SOC and measurement registers
+ *
+ * @param device simulated gauge
+ */
+void STC3115SimulatedI2CBus::updateMeasurements(Device* device) {
+    bool voltageMode = (device->registers[STC3115_REG_MODE] & STC3115_VMODE) != 0;
+    int current = voltageMode ? 0 : device->current;
+
+    setWord(device, STC3115_REG_SOC_L, device->hrsoc);
+    int rawCurrent = current * 4096 / (CurrentFactor / device->rSense);
+    if (rawCurrent > 0x1fff) {
+        rawCurrent = 0x1fff;
+    } else if (rawCurrent < -0x2000) {
+        rawCurrent = -0x2000;
+    }
+
+    setWord(device, STC3115_REG_CURRENT_L, rawCurrent & 0x3fff);
+    setWord(device, STC3115_REG_VOLTAGE_L, ((device->voltage * 4096 + VoltageFactor / 2) / VoltageFactor) & 0x0fff);
+    device->registers[STC3115_REG_TEMPERATURE] = static_cast<uint8_t>(device->temperature);
+}
+
+void STC3115SimulatedI2CBus::setWord(Device* device, uint8_t reg, int value) {
+    device->registers[reg] = value & 0xff;
+    device->registers[reg + 1] = (value >> 8) & 0xff;
+}
+
+int STC3115SimulatedI2CBus::getWord(Device* device, uint8_t reg) {
+    return device->registers[reg] | (device->registers[reg + 1] << 8);
+}
+
+/**
+ * @brief Linear OCV curve between 3.3 V (empty) and 4.2 V (full)
+ *
+ * @param ocv open circuit voltage in mV
+ * @return int HRSOC
+ */
+int STC3115SimulatedI2CBus::socFromOCV(int ocv) {
+    if (ocv <= 3300) {
+        return 0;
+    }
+
+    if (ocv >= 4200) {
+        return MAX_HRSOC;
+    }
+
+    return static_cast<int>(static_cast<long>(ocv - 3300) * MAX_HRSOC / 900);
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef STC3115_SIMULATED_I2C_BUS_H
+#define STC3115_SIMULATED_I2C_BUS_H
+
+#if !defined(ARDUINO)
+
+#include <mutex>
+#include "STC3115LinuxI2C.h"
+#include "STC3115_constants.h"
+
+#ifndef STC3115_SIMULATED_MAX_DEVICES
+#define STC3115_SIMULATED_MAX_DEVICES 8
+#endif
+
+/**
+ * @brief In-process I2C adapter emulating one or more STC3115 gauges, for host testing without hardware.
+ *
+ * Each device has a 64-byte register map with the side effects the driver relies on: soft reset through PORDET,
+ * conversion counter reset on GG_RUN and GG_RST, SOC initialization from OCV, and coulomb counting on step().
+ */
+class STC3115SimulatedI2CBus : public STC3115I2CBus {
+public:
+    STC3115SimulatedI2CBus();
+    virtual ~STC3115SimulatedI2CBus();
+
+    bool addDevice(uint8_t address, int capacity = 610, int rSense = 50);
+    bool setBattery(uint8_t address, int voltage, int current, int temperature);
+    bool setPresent(uint8_t address, bool present);
+    bool powerOnReset(uint8_t address);
+    bool getRegisters(uint8_t address, uint8_t* output);
+    void step();
+    uint32_t getTransferCount();
+
+    virtual bool transfer(struct i2c_msg* messages, size_t count);
+private:
+    struct Device {
+        uint8_t address;
+        uint8_t registers[STC3115_REGISTER_MAP_SIZE];
+        uint8_t pointer;
+        int capacity;
+        int rSense;
+        int voltage;
+        int current;
+        int temperature;
+        bool present;
+        int hrsoc;
+        long long charge;
+    };
+
+    Device* find(uint8_t address);
+    void reset(Device* device);
+    void writeByte(Device* device, uint8_t reg, uint8_t value);
+    void updateMeasurements(Device* device);
+    static void setWord(Device* device, uint8_t reg, int value);
+    static int getWord(Device* device, uint8_t reg);
+    static int socFromOCV(int ocv);
+
+    Device devices[STC3115_SIMULATED_MAX_DEVICES];
+    size_t deviceCount;
+    uint32_t transferCount;
+    std::mutex lock;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,180 @@
+#include "STC3115Statistics.h"
+
+STC3115Statistics::STC3115Statistics():
+ window(STC3115_STAT_MAX_WINDOW) {
+    reset();
+}
+
+/**
+ * @brief Set the number of samples covered by the window statistics. Clears every statistic.
+ *
+ * @param window number of samples, from 1 to STC3115_STAT_MAX_WINDOW
+ * @return true
+ * @return false if the window is out of range
+ */
+bool STC3115Statistics::setWindow(uint8_t window) {
+    if (window == 0 || window > STC3115_STAT_MAX_WINDOW) {
+        return false;
+    }
+
+    this->window = window;
+    reset();
+
+    return true;
+}
+
+/**
+ * @brief Get the number of samples covered by the window statistics
+ *
+ * @return uint8_t
+ */
+uint8_t STC3115Statistics::getWindow() {
+    return window;
+}
+
+/**
+ * @brief Clear every statistic
+ *
+ */
+void STC3115Statistics::reset() {
+    for (int i = 0; i < STC3115_STAT_CHANNEL_COUNT; i++) {
+        clearChannel(&channels[i]);
+    }
+
+    position = 0;
+    filled = 0;
+    lastCounter = -1;
+}
+
+/**
+ * @brief Add a decoded measurement set. Sets with the same conversion counter as the previous one are ignored.
+ *
+ * @param data decoded measurement set
+ */
+void STC3115Statistics::update(const STC3115BatteryData& data) {
+    if (data.ConvCounter == lastCounter) {
+        return;
+    }
+
+    lastCounter = data.ConvCounter;
+
+    STC3115StatisticsSummary summary;
+    int16_t values[STC3115_STAT_CHANNEL_COUNT];
+    values[STC3115_STAT_VOLTAGE] = data.Voltage;
+    values[STC3115_STAT_CURRENT] = data.Current;
+    values[STC3115_STAT_TEMPERATURE] = data.Temperature;
+
+    for (int i = 0; i < STC3115_STAT_CHANNEL_COUNT; i++) {
+        add(&channels[i], values[i], &summary);
+        summaries[i].publish(summary);
+    }
+
+    position = slot(position, 1);
+    if (filled < window) {
+        filled++;
+    }
+}
+
+/**
+ * @brief Get the latest statistics of a measurement. Safe to call from any task while sampling continues.
+ *
+ * @param channel measurement
+ * @param summary pointer to the structure that will hold the statistics
+ * @return true
+ * @return false if the channel is invalid or the writer kept publishing during the copy
+ */
+bool STC3115Statistics::getSummary(STC3115StatChannel channel, STC3115StatisticsSummary* summary) {
+    if (channel >= STC3115_STAT_CHANNEL_COUNT) {
+        return false;
+    }
+
+    return summaries[channel].read(summary, NULL, STC3115_SNAPSHOT_RETRIES);
+}
+
+/**
+ * @brief Add a sample to one channel and compute its summary
+ *
+ * @param channel channel state
+ * @param value new sample
+ * @param summary pointer to the structure that will hold the summary
+ */
+void STC3115Statistics::add(Channel* channel, int16_t value, STC3115StatisticsSummary* summary) {
+    if (filled == window) {
+        int16_t oldest = channel->values[position];
+        channel->sum -= oldest;
+        channel->squareSum -= static_cast<int32_t>(oldest) * oldest;
+
+        if (channel->minCount > 0 && channel->minQueue[channel->minHead] == position) {
+            channel->minHead = slot(channel->minHead, 1);
+            channel->minCount--;
+        }
+
+        if (channel->maxCount > 0 && channel->maxQueue[channel->maxHead] == position) {
+            channel->maxHead = slot(channel->maxHead, 1);
+            channel->maxCount--;
+        }
+    }
+
+    channel->values[position] = value;
+    channel->sum += value;
+    channel->squareSum += static_cast<int32_t>(value) * value;
+
+    while (channel->minCount > 0 && channel->values[channel->minQueue[slot(channel->minHead, channel->minCount - 1)]] >= value) {
+        channel->minCount--;
+    }
+    channel->minQueue[slot(channel->minHead, channel->minCount)] = position;
+    channel->minCount++;
+
+    while (channel->maxCount > 0 && channel->values[channel->maxQueue[slot(channel->maxHead, channel->maxCount - 1)]] <= value) {
+        channel->maxCount--;
+    }
+    channel->maxQueue[slot(channel->maxHead, channel->maxCount)] = position;
+    channel->maxCount++;
+
+    int32_t scaled = static_cast<int32_t>(value) * (1 << STC3115_STAT_FRACTION_BITS);
+    int32_t delta = scaled - channel->mean;
+    int32_t count = ++channel->count;
+    channel->mean += delta / count;
+    channel->remainder += delta % count;
+    if (channel->remainder >= count) {
+        channel->mean++;
+        channel->remainder -= count;
+    } else if (channel->remainder <= -count) {
+        channel->mean--;
+        channel->remainder += count;
+    }
+    channel->m2 += static_cast<int64_t>(delta) * (scaled - channel->mean);
+
+    int32_t n = filled < window ? filled + 1 : window;
+    summary->WindowCount = n;
+    summary->WindowMean = (channel->sum >= 0 ? channel->sum + n / 2 : channel->sum - n / 2) / n;
+    summary->WindowVariance = n > 1 ? static_cast<int32_t>((channel->squareSum - static_cast<int64_t>(channel->sum) * channel->sum / n) / (n - 1)) : 0;
+    summary->WindowMin = channel->values[channel->minQueue[channel->minHead]];
+    summary->WindowMax = channel->values[channel->maxQueue[channel->maxHead]];
+    summary->TotalCount = channel->count;
+    int32_t half = 1 << (STC3115_STAT_FRACTION_BITS - 1);
+    summary->TotalMean = (channel->mean >= 0 ? channel->mean + half : channel->mean - half) / (1 << STC3115_STAT_FRACTION_BITS);
+    summary->TotalVariance = channel->count > 1 ? static_cast<int32_t>((channel->m2 / (channel->count - 1)) >> (2 * STC3115_STAT_FRACTION_BITS)) : 0;
+}
+
+void STC3115Statistics::clearChannel(Channel* channel) {
+    channel->minHead = 0;
+    channel->minCount = 0;
+    channel->maxHead = 0;
+    channel->maxCount = 0;
+    channel->sum = 0;
+    channel->squareSum = 0;
+    channel->count = 0;
+    channel->mean = 0;
+    channel->remainder = 0;
+    channel->m2 = 0;
+}
+
+/**
+ * @brief Advance a ring index by an offset
+ *
+ */
+uint8_t STC3115Statistics::slot(uint8_t head, uint8_t offset) {
+    uint8_t index = head + offset;
+    return index >= window ? index - window : index;
+}
@@ -0,0 +1,87 @@
+#ifndef STC3115_STATISTICS_H
+#define STC3115_STATISTICS_H
+
+#include <stdint.h>
+#include "STC3115_types.h"
+#include "STC3115SeqLock.h"
+
+#ifndef STC3115_STAT_MAX_WINDOW
+#define STC3115_STAT_MAX_WINDOW 32
+#endif
+
+#define STC3115_STAT_FRACTION_BITS 8
+
+/**
+ * @brief Measurement tracked by STC3115Statistics
+ *
+ */
+typedef enum {
+    STC3115_STAT_VOLTAGE = 0,
+    STC3115_STAT_CURRENT,
+    STC3115_STAT_TEMPERATURE,
+    STC3115_STAT_CHANNEL_COUNT
+} STC3115StatChannel;
+
+/**
+ * @brief Statistics of one measurement, in the unit of STC3115BatteryData (mV, mA, 0.1 degree).
+ *
+ * Window values cover the last WindowCount samples, Total values every sample since the last reset.
+ */
+typedef struct {
+    uint16_t WindowCount;
+    int32_t WindowMean;
+    int32_t WindowVariance;
+    int32_t WindowMin;
+    int32_t WindowMax;
+    uint32_t TotalCount;
+    int32_t TotalMean;
+    int32_t TotalVariance;
+} STC3115StatisticsSummary;
+
+/**
+ * @brief Streaming statistics of voltage, current and temperature with constant work per sample.
+ *
+ * Lifetime mean and variance use fixed-point Welford accumulators; the division remainder of the mean update is
+ * carried over so the mean keeps moving after millions of samples. Window mean and variance use exact integer
+ * sums over a ring buffer, and window min/max use monotonic deques over the same buffer. Summaries are published
+ * through a sequence lock, so other tasks can query them while sampling continues.
+ */
+class STC3115Statistics {
+public:
+    STC3115Statistics();
+
+    bool setWindow(uint8_t window);
+    uint8_t getWindow();
+    void reset();
+    void update(const STC3115BatteryData& data);
+    bool getSummary(STC3115StatChannel channel, STC3115StatisticsSummary* summary);
+private:
+    struct Channel {
+        int16_t values[STC3115_STAT_MAX_WINDOW];
+        uint8_t minQueue[STC3115_STAT_MAX_WINDOW];
+        uint8_t maxQueue[STC3115_STAT_MAX_WINDOW];
+        uint8_t minHead;
+        uint8_t minCount;
+        uint8_t maxHead;
+        uint8_t maxCount;
+        int32_t sum;
+        int64_t squareSum;
+        uint32_t count;
+        int32_t mean;
+        int32_t remainder;
+        int64_t m2;
+    };
+
+    void add(Channel* channel, int16_t value, STC3115StatisticsSummary* summary);
+    void clearChannel(Channel* channel);
+    uint8_t slot(uint8_t head, uint8_t offset);
+
+    Channel channels[STC3115_STAT_CHANNEL_COUNT];
+    STC3115SeqLock<STC3115StatisticsSummary> summaries[STC3115_STAT_CHANNEL_COUNT];
+    uint8_t window;
+    uint8_t position;
+    uint8_t filled;
+    int lastCounter;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef STC3115_CONFIG_H
+#define STC3115_CONFIG_H
+
+/**
+ * Build profile and optional features.
+ *
+ * Define STC3115_LOW_RAM (-DSTC3115_LOW_RAM) for small AVR targets: measurement and configuration structures use right-sized integer types, the constant OCV
+ * offset table stays in flash and every optional feature below defaults to off. Each feature can still be
+ * switched individually by defining its macro to 0 or 1.
+ *
+ * These macros change the layout of STC3115 and of the measurement structures, so they must be global build flags
+ * seen by every translation unit, including the library sources: e.g. build_flags in platformio.ini, or
+ * compiler.cpp.extra_flags for the Arduino IDE. A #define in a sketch does not reach the library sources and
+ * leaves the sketch and the library with mismatched class layouts.
+ *
+ * RAM used by each feature of a gauge instance is reported at run time by STC3115::getFootprint().
+ */
+
+#if defined(STC3115_LOW_RAM)
+#define STC3115_FEATURE_DEFAULT 0
+#else
+#define STC3115_FEATURE_DEFAULT 1
+#endif
+
+#ifndef STC3115_COMPACT_TYPES
+#define STC3115_COMPACT_TYPES (!STC3115_FEATURE_DEFAULT)
+#endif
+
+#ifndef STC3115_OCV_OFFSET_IN_FLASH
+#define STC3115_OCV_OFFSET_IN_FLASH (!STC3115_FEATURE_DEFAULT)
+#endif
+
+#ifndef STC3115_ENABLE_REGISTER_CACHE
+#define STC3115_ENABLE_REGISTER_CACHE STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_SNAPSHOT
+#define STC3115_ENABLE_SNAPSHOT STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_EVENTS
+#define STC3115_ENABLE_EVENTS STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_ENERGY
+#define STC3115_ENABLE_ENERGY STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_STATISTICS
+#define STC3115_ENABLE_STATISTICS STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_DRIFT
+#define STC3115_ENABLE_DRIFT STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_DERATING
+#define STC3115_ENABLE_DERATING STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_RINT
+#define STC3115_ENABLE_RINT STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_FAST_FIRST_READING
+#define STC3115_ENABLE_FAST_FIRST_READING STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_CHARGE_PHASE
+#define STC3115_ENABLE_CHARGE_PHASE STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_HEALTH
+#define STC3115_ENABLE_HEALTH STC3115_FEATURE_DEFAULT
+#endif
+
+#ifndef STC3115_ENABLE_DEBUG
+#define STC3115_ENABLE_DEBUG STC3115_FEATURE_DEFAULT
+#endif
+
+/**
+ * Size budgets checked at compile time in the low-RAM profile. Pointer-sized members (vtable, bus) are
+ * accounted separately so the same budget holds on AVR and on a host build of the profile.
+ */
+#ifndef STC3115_LOW_RAM_BATTERY_DATA_BUDGET
+#define STC3115_LOW_RAM_BATTERY_DATA_BUDGET 22
+#endif
+
+#ifndef STC3115_LOW_RAM_CONFIG_BUDGET
+#define STC3115_LOW_RAM_CONFIG_BUDGET 14
+#endif
+
+#ifndef STC3115_LOW_RAM_GAUGE_BUDGET
+#define STC3115_LOW_RAM_GAUGE_BUDGET 80
+#endif
+
+#endif
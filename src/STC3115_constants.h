@@ -20,7 +20,10 @@
 #define STC3115_ID          0x14
 #define STC3115_RAM_SIZE    16
 #define STC3115_OCVTAB_SIZE 16
+#define STC3115_REGISTER_MAP_SIZE 64
 #define VCOUNT				4
+#define STC3115_CONV_PERIOD_MIXED_MS 500
+#define STC3115_CONV_PERIOD_VM_MS 4000
 #define VM_MODE 			1
 #define CC_MODE 			0
 #define MIXED_MODE			0
@@ -30,6 +33,21 @@
 #define VoltageFactor  		9011
 #define CurrentFactor		24084
 #define VOLTAGE_SECURITY_RANGE 200
+#define STC3115_PROGRAM_STEPS 9
+#define STC3115_RUN_MAX_STEP_TRANSACTIONS 4
+#define STC3115_SNAPSHOT_RETRIES 16
+#define STC3115_STATE_VERSION 2
+
+#define STC3115_FIELD_SOC           0x01
+#define STC3115_FIELD_COUNTER       0x02
+#define STC3115_FIELD_CURRENT       0x04
+#define STC3115_FIELD_VOLTAGE       0x08
+#define STC3115_FIELD_TEMPERATURE   0x10
+#define STC3115_FIELD_OCV           0x20
+#define STC3115_FIELD_ALL           0x3F
+#define STC3115_FIELD_COUNT         6
+#define STC3115_READ_MERGE_GAP      3
+#define STC3115_IDLE_CURRENT 5
 
 #define RAM_TESTWORD 		0x53A9
 #define STC3115_UNINIT    0
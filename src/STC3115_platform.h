@@ -0,0 +1,89 @@
+#ifndef STC3115_PLATFORM_H
+#define STC3115_PLATFORM_H
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define STC3115_PROGMEM PROGMEM
+#define stc3115_read_flash(destination, source, length) memcpy_P(destination, source, length)
+#endif
+
+#elif defined(__linux__)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifndef DEC
+#define DEC 10
+#endif
+
+#ifndef HEX
+#define HEX 16
+#endif
+
+/**
+ * @brief Milliseconds since an arbitrary point, like Arduino's millis()
+ *
+ * @return unsigned long
+ */
+inline unsigned long millis() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<unsigned long>(now.tv_sec * 1000UL + now.tv_nsec / 1000000UL);
+}
+
+/**
+ * @brief Microseconds since an arbitrary point, like Arduino's micros()
+ *
+ * @return unsigned long
+ */
+inline unsigned long micros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<unsigned long>(now.tv_sec * 1000000UL + now.tv_nsec / 1000UL);
+}
+
+/**
+ * @brief Minimal replacement of Arduino's Stream used for debug output on Linux hosts
+ *
+ */
+class Stream {
+public:
+    Stream(FILE* file = stderr): file(file) {}
+    virtual ~Stream() {}
+
+    size_t print(const char* value) { return fprintf(file, "%s", value); }
+    size_t print(char value) { return fprintf(file, "%c", value); }
+    size_t print(int value, int base = DEC) { return print(static_cast<long>(value), base); }
+    size_t print(unsigned int value, int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+    size_t print(long value, int base = DEC) { return base == HEX ? fprintf(file, "%lX", value) : fprintf(file, "%ld", value); }
+    size_t print(unsigned long value, int base = DEC) { return base == HEX ? fprintf(file, "%lX", value) : fprintf(file, "%lu", value); }
+    size_t print(double value) { return fprintf(file, "%.2f", value); }
+
+    template <typename T>
+    size_t println(T value) { return print(value) + fprintf(file, "\n"); }
+    template <typename T>
+    size_t println(T value, int base) { return print(value, base) + fprintf(file, "\n"); }
+    size_t println() { return fprintf(file, "\n"); }
+private:
+    FILE* file;
+};
+
+#else
+#error "STC3115 driver requires the Arduino core or a Linux host"
+#endif
+
+#ifndef STC3115_PROGMEM
+#include <string.h>
+#define STC3115_PROGMEM
+#define stc3115_read_flash(destination, source, length) memcpy(destination, source, length)
+#endif
+
+#endif
@@ -3,21 +3,66 @@
 
 #include <stdint.h>
 #include "STC3115_constants.h"
+#include "STC3115_config.h"
+
+/**
+ * @brief Integer types of the configuration and measurement fields
+ *
+ * Plain int by default. The compact types fit the register ranges of the gauge and are used by the low-RAM profile.
+ */
+#if STC3115_COMPACT_TYPES
+typedef int16_t stc3115_word_t;
+typedef uint16_t stc3115_uword_t;
+typedef uint8_t stc3115_byte_t;
+#else
+typedef int stc3115_word_t;
+typedef int stc3115_uword_t;
+typedef int stc3115_byte_t;
+#endif
+
+/**
+ * @brief Caching policy of a register in the STC3115I2CCore register shadow
+ *
+ */
+typedef enum {
+    STC3115_POLICY_VOLATILE = 0,
+    STC3115_POLICY_WRITE_THROUGH,
+    STC3115_POLICY_CACHE_FOREVER
+} STC3115RegisterPolicy;
+
+/**
+ * @brief Step of the update cycle performed by STC3115::run()
+ *
+ */
+typedef enum {
+    STC3115_STEP_STATUS = 0,
+    STC3115_STEP_RAM,
+    STC3115_STEP_RESET,
+    STC3115_STEP_RECOVER,
+    STC3115_STEP_PROGRAM,
+    STC3115_STEP_RESUME,
+    STC3115_STEP_MEASURE,
+    STC3115_STEP_TRACK,
+    STC3115_STEP_TUNE,
+    STC3115_STEP_STORE
+} STC3115RunStep;
 
 /**
  * @brief STC3115 configuration structure
  *
  */
 typedef struct {
-    int VMode;
-    int AlmSOC;
-    int AlmVbat;
-    int CCConf;
-    int VMConf;
-    int CNom;
-    int RSense;
-    int RelaxCurrent;
+    stc3115_byte_t VMode;
+    stc3115_byte_t AlmSOC;
+    stc3115_word_t AlmVbat;
+    stc3115_word_t CCConf;
+    stc3115_word_t VMConf;
+    stc3115_word_t CNom;
+    stc3115_word_t RSense;
+    stc3115_word_t RelaxCurrent;
+#if !STC3115_OCV_OFFSET_IN_FLASH
     uint8_t OCVOffset[16];
+#endif
 } STC3115ConfigData;
 
 /**
@@ -25,19 +70,83 @@ typedef struct {
  *
  */
 typedef struct {
-    int StatusWord;
-    int HRSOC;
-    int SOC;
-    int Voltage;
-    int Current;
-    int Temperature;
-    int ConvCounter;
-    int OCV;
-    int Presence;
-    int ChargeValue;
-    int RemTime;
+    stc3115_uword_t StatusWord;
+    stc3115_uword_t HRSOC;
+    stc3115_word_t SOC;
+    stc3115_word_t Voltage;
+    stc3115_word_t Current;
+    stc3115_word_t Temperature;
+    stc3115_uword_t ConvCounter;
+    stc3115_word_t OCV;
+    stc3115_byte_t Presence;
+    stc3115_byte_t Provisional;
+    stc3115_word_t ChargeValue;
+    stc3115_word_t RemTime;
 } STC3115BatteryData;
 
+/**
+ * @brief Gauge adjustment diagnostics decoded by STC3115DriftMonitor
+ *
+ * Adjustments are in 0.01% of SOC, rates in 0.01% of SOC per hour. Accumulated values include the amounts
+ * cleared from the gauge accumulators by the monitor.
+ */
+typedef struct {
+    int32_t CCAdjust;
+    int32_t VMAdjust;
+    int32_t CCAccumulated;
+    int32_t VMAccumulated;
+    int32_t CCRate;
+    int32_t VMRate;
+    uint32_t Samples;
+} STC3115DriftData;
+
+/**
+ * @brief Contiguous register range fetched in one bus transaction
+ *
+ */
+typedef struct {
+    uint8_t Start;
+    uint8_t Length;
+} STC3115ReadSpan;
+
+/**
+ * @brief Charge and energy throughput integrated by STC3115EnergyCounter
+ *
+ * Charge is in mA*ms, energy in uW*ms (mV*mA*ms), time in ms.
+ */
+typedef struct {
+    uint64_t ChargeIn;
+    uint64_t ChargeOut;
+    uint64_t EnergyIn;
+    uint64_t EnergyOut;
+    uint64_t TimeCharging;
+    uint64_t TimeDischarging;
+    uint64_t TimeIdle;
+} STC3115EnergyState;
+
+/**
+ * @brief Capacity estimate of STC3115HealthEstimator
+ *
+ * Capacities are in mAh. Capacity is only valid when Measurements is not 0.
+ */
+typedef struct {
+    uint16_t Nominal;
+    uint16_t Capacity;
+    uint16_t Measurements;
+    uint16_t Rejected;
+} STC3115HealthState;
+
+/**
+ * @brief Driver state that survives a power cycle of the host when stored by the application
+ *
+ */
+typedef struct {
+    uint16_t Version;
+    uint16_t Size;
+    STC3115EnergyState Energy;
+    STC3115HealthState Health;
+} STC3115PersistentState;
+
 /**
  * @brief STC3115 RAM data internal structure
  *
@@ -60,4 +169,26 @@ typedef union {
     } reg;
 } STC3115RAMData;
 
+/**
+ * @brief RAM used by one STC3115 instance, per feature, in bytes
+ *
+ * Disabled features report 0. Core covers the configuration, measurement and RAM image structures and any padding.
+ */
+typedef struct {
+    uint16_t Core;
+    uint16_t RegisterCache;
+    uint16_t Snapshot;
+    uint16_t Events;
+    uint16_t Energy;
+    uint16_t Statistics;
+    uint16_t Drift;
+    uint16_t Derating;
+    uint16_t Rint;
+    uint16_t FastFirstReading;
+    uint16_t ChargePhase;
+    uint16_t Health;
+    uint16_t Debug;
+    uint16_t Total;
+} STC3115Footprint;
+
 #endif